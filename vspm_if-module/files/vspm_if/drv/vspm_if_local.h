@@ -59,14 +59,41 @@
 #define __VSPM_IF_LOCAL_H__
 
 #include <linux/sched.h>
+#include <linux/kref.h>
+#include <linux/idr.h>
+#include <linux/mutex.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
+#include <linux/dma-fence.h>
 
 extern struct platform_device *g_vspmif_pdev;
+extern struct kmem_cache *g_vspmif_entry_cache;
 
 /* define assigned memory size */
-#define VSPM_IF_MEM_SIZE			(24576)
 #define VSPM_IF_RPF_CLUT_SIZE		(2048)
 #define VSPM_IF_HGO_SIZE			(1280)
 #define VSPM_IF_HGT_SIZE			(1024)
+#define VSPM_IF_DL_SIZE				(12288)
+#define VSPM_IF_MEM_ALIGN			(256)
+
+/* size class of assigned memory */
+enum {
+	VSPM_IF_MEM_CLUT = 0,
+	VSPM_IF_MEM_HGO,
+	VSPM_IF_MEM_HGT,
+	VSPM_IF_MEM_DL,
+	VSPM_IF_MEM_CLASS_NUM,
+};
+
+/* CLUT x5, HGO, HGT and display list */
+#define VSPM_IF_WORK_REGION_MAX		(8)
+
+/* registered tables referenced by one job (CLUT x5, LUT and CLU) */
+#define VSPM_IF_WORK_TBL_MAX		(7)
+
+/* cache of assigned memory */
+#define VSPM_IF_MEM_PREWARM			(4)
+#define VSPM_IF_MEM_PCP_SIZE		(4)
 
 /* define macro */
 #define IPRINT(fmt, args...) \
@@ -85,19 +112,163 @@ extern struct platform_device *g_vspmif_pdev;
 #define VSPM_IF_CP_TO_INT(addr) \
 	((unsigned int)((unsigned long)(addr)))
 
+/* address registers of VSP/FDP are 32bit */
+#define VSPM_IF_DMA_MASK	DMA_BIT_MASK(32)
+#define VSPM_IF_DMA_TO_INT(addr) \
+	((unsigned int)lower_32_bits(addr))
+
+/* work memory structure */
+struct vspm_if_work_mem_t {
+	struct list_head list;	/* cache list */
+	void *virt_addr;
+	dma_addr_t hard_addr;
+	unsigned int cls;
+};
+
+/* cache of work memory structure (per size class) */
+struct vspm_if_mem_pcp_t {
+	unsigned int num;
+	struct vspm_if_work_mem_t *mem[VSPM_IF_MEM_PCP_SIZE];
+};
+
+struct vspm_if_mem_cache_t {
+	spinlock_t lock;	/* protects the global list */
+	struct list_head list;
+	unsigned int num;
+	struct vspm_if_mem_pcp_t __percpu *pcp;
+};
+
 /* work buffer structure */
 struct vspm_if_work_buff_t {
-	dma_addr_t hard_addr;
-	void *virt_addr;
+	struct vspm_if_work_mem_t *mem[VSPM_IF_WORK_REGION_MAX];
+	unsigned int num;	/* number of assigned memory */
+	struct vspm_if_tbl_t *tbl_ref[VSPM_IF_WORK_TBL_MAX];
+	unsigned int tbl_ref_num;	/* number of referenced tables */
 	unsigned int use_flag;
-	unsigned int offset;
 	void *next_buff;
+	struct list_head list;	/* free list */
+	struct vspm_if_work_pool_t *pool;
+	/* display list of configured size (kept until close) */
+	void *dl_virt_addr;
+	dma_addr_t dl_hard_addr;
+	unsigned int dl_size;
+	unsigned int dl_used;
+};
+
+/* registered table structure */
+struct vspm_if_tbl_t {
+	struct kref ref;
+	struct vspm_if_work_mem_t *mem;	/* NULL if allocated directly */
+	void *virt_addr;
+	dma_addr_t hard_addr;
+	unsigned int size;
+	unsigned short tbl_num;
+	struct list_head list;	/* deferred free list */
+};
+
+/* imported dma-buf structure */
+struct vspm_if_dmabuf_t {
+	struct dma_buf *dmabuf;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+	dma_addr_t addr;
+	unsigned int ref;	/* number of imports */
+	struct list_head list;	/* retire list */
+	unsigned long long seq;	/* jobs entried before release */
+};
+
+/* fixed buffer table structure */
+struct vspm_if_buf_table_t {
+	struct kref ref;
+	struct list_head list;	/* deferred free list */
+	unsigned int num;
+	struct vspm_if_dmabuf_t *buf[];	/* NULL means empty entry */
+};
+
+/* exported image buffer structure */
+struct vspm_if_export_buf_t {
+	void *virt_addr;	/* cached */
+	dma_addr_t hard_addr;
+	size_t size;
+};
+
+/* user pointer mapping structure */
+struct vspm_if_uptr_t {
+	struct list_head list;	/* LRU list (or retire list) */
+	struct mm_struct *mm;
+	unsigned long user_addr;
+	unsigned int size;
+	struct page **pages;
+	unsigned int npages;
+	struct sg_table sgt;
+	dma_addr_t addr;
+	unsigned int ref;	/* number of maps */
+	unsigned long long seq;	/* jobs entried before unmap */
+	unsigned int pending;	/* CPU sync waits for the jobs */
+};
+
+/* in-fences of job structure */
+struct vspm_if_in_fence_t {
+	struct list_head list;
+	struct vspm_if_entry_data_t *entry_data;
+	atomic_t pending;	/* fences not signaled yet */
+	int error;		/* error of the signaled fences */
+	unsigned int num;
+	struct vspm_if_fence_wait_t {
+		struct dma_fence *fence;
+		struct dma_fence_cb cb;
+		struct vspm_if_in_fence_t *in_fence;
+	} wait[];
+};
+
+/* extent of image planes in a fixed buffer */
+struct vspm_if_plane_size_t {
+	unsigned long long size;	/* luma (or packed) plane */
+	unsigned long long size_c;	/* each chroma plane */
+};
+
+/* out-fence fd reserved until the result is copied to user */
+struct vspm_if_fence_fd_t {
+	int fd;
+	struct file *file;
+};
+
+/* work buffer pool structure */
+struct vspm_if_work_pool_t {
+	spinlock_t lock;	/* protects the free list and counters */
+	struct list_head free;
+	unsigned int num;
+	unsigned int used;
+	unsigned int peak;	/* high-water mark of used */
+	unsigned int mem_used;	/* bytes of assigned memory */
+	unsigned int mem_peak;
+	unsigned int dl_size;	/* 0 means the display list size class */
+};
+
+/* callback data structure */
+struct vspm_if_cb_data_t {
+	struct list_head list;
+	struct vspm_if_cb_rsp_t rsp;
+	struct vspm_cb_vsp_hgo {
+		void *virt_addr;
+		void *user_addr;
+	} vsp_hgo;
+	struct vspm_cb_vsp_hgt {
+		void *virt_addr;
+		void *user_addr;
+	} vsp_hgt;
+	struct vspm_if_work_buff_t *vsp_work_buff;
 };
 
 /* entry data structure */
 struct vspm_if_entry_data_t {
 	struct list_head list;
 	struct vspm_if_private_t *priv;
+	struct vspm_if_tmpl_t *tmpl;
+	struct vspm_if_buf_table_t *buf_table;
+	struct dma_fence *fence;	/* signaled when the job is done */
+	unsigned long long seq;	/* order of entry in the fd */
+	struct vspm_if_cb_data_t cb_data;	/* after the job is done */
 	struct vspm_if_entry_t entry;
 	struct vspm_job_t job;
 	union {
@@ -168,19 +339,51 @@ struct vspm_if_entry_data_t {
 	} ip_par;
 };
 
-/* callback data structure */
-struct vspm_if_cb_data_t {
+/* job template structure */
+struct vspm_if_tmpl_t {
+	struct kref ref;
+	struct vspm_if_entry_data_t entry_data;
+};
+
+/* entry data pool structure */
+struct vspm_if_entry_pool_t {
 	struct list_head list;
-	struct vspm_if_cb_rsp_t rsp;
-	struct vspm_cb_vsp_hgo {
-		void *virt_addr;
-		void *user_addr;
-	} vsp_hgo;
-	struct vspm_cb_vsp_hgt {
-		void *virt_addr;
-		void *user_addr;
-	} vsp_hgt;
-	struct vspm_if_work_buff_t *vsp_work_buff;
+	unsigned int depth;
+	unsigned int free;
+	unsigned int miss;	/* allocated out of pool */
+};
+
+/* source of 32bit parameter (NULL means user space) */
+struct vspm_if_par_src_t {
+	const void *desc;	/* flat job descriptor */
+	unsigned int size;
+};
+
+/* submission queue structure */
+struct vspm_if_sq_t {
+	struct mutex lock;	/* serializes the consumers of the ring */
+	struct vspm_if_sq_ring_t *ring;
+	struct vspm_if_sqe_t *sqes;
+	unsigned char *arena;
+	unsigned int ring_size;
+	unsigned int entries;
+	unsigned int arena_size;
+	unsigned int head;
+	void *desc;		/* flat job descriptor copied from the arena */
+	struct vspm_if_entry_data_t *err_rec;	/* reserved for an error */
+	struct task_struct *thread;
+	unsigned long idle_time;	/* jiffies */
+};
+
+/* completion queue structure */
+struct vspm_if_cq_t {
+	struct vspm_if_cq_ring_t *ring;
+	struct vspm_if_cqe_t *cqes;
+	unsigned int ring_size;
+	unsigned int entries;
+	unsigned int tail;
+	wait_queue_head_t wait;
+	int stop;
 };
 
 /* private data structure */
@@ -191,16 +394,57 @@ struct vspm_if_private_t {
 	struct vspm_if_cb_data_t cb_data;
 	struct completion wait_interrupt;
 	struct completion wait_thread;
+	wait_queue_head_t poll_wait;
 	struct semaphore sem;
 	struct vspm_if_work_buff_t *work_buff;
+	struct vspm_if_work_pool_t work_pool;
 	void *handle;
+	unsigned short type;	/* module type of handle */
+	void *pipe_handle;	/* VSP stage of pipeline jobs */
+	struct mutex tmpl_lock;	/* protects the template table */
+	struct idr tmpl_idr;
+	struct mutex tbl_lock;	/* protects the table cache */
+	struct idr tbl_idr;
+	unsigned int table_num;
+	struct mutex dmabuf_lock;	/* protects the dma-buf cache */
+	struct idr dmabuf_idr;
+	unsigned int dmabuf_num;
+	struct vspm_if_buf_table_t *buf_table;	/* by dmabuf_lock */
+	struct list_head dmabuf_retire;	/* released while jobs run */
+	struct mutex uptr_lock;	/* protects the user pointer cache */
+	struct list_head uptr_lru;	/* most recently used first */
+	struct list_head uptr_retire;	/* evicted while jobs run */
+	unsigned int uptr_num;
+	unsigned int uptr_miss;
+	struct list_head in_fence_list;	/* by lock */
+	struct work_struct fence_work;	/* entries the jobs to VSPM */
+	unsigned long long job_seq;	/* by lock, for the next job */
+	unsigned int retire_num;	/* by lock, waiting for jobs */
+	struct work_struct retire_work;	/* releases after the jobs */
+	struct mutex ring_lock;	/* serializes the ring setup */
+	struct vspm_if_sq_t *sq;
+	struct vspm_if_cq_t *cq;
+	struct vspm_if_config_t config;
+	struct vspm_if_entry_pool_t entry_pool;
 };
 
 /* sub function */
 void release_all_entry_data(struct vspm_if_private_t *priv);
 void release_all_cb_data(struct vspm_if_private_t *priv);
+void release_sq(struct vspm_if_private_t *priv);
+void release_cq(struct vspm_if_private_t *priv);
 
+int init_entry_pool(struct vspm_if_private_t *priv);
+void release_entry_pool(struct vspm_if_private_t *priv);
+struct vspm_if_entry_data_t *get_entry_data(struct vspm_if_private_t *priv);
+void put_entry_data(struct vspm_if_entry_data_t *entry_data);
+
+int init_work_mem_pools(struct device *dev);
+void release_work_mem_pools(void);
+void trim_work_mem_cache(void);
+void get_work_mem_stats(struct vspm_if_stats_t *stats);
 struct vspm_if_work_buff_t *get_work_buffer(struct vspm_if_private_t *priv);
+void put_work_buffer(struct vspm_if_work_buff_t *work_buff);
 void release_work_buffers(struct vspm_if_private_t *priv);
 
 int free_vsp_par(struct vspm_entry_vsp *vsp);
@@ -208,6 +452,7 @@ int set_vsp_par(
 	struct vspm_if_entry_data_t *entry,
 	struct vsp_start_t *vsp_par);
 int free_cb_vsp_par(struct vspm_if_cb_data_t *cb_data);
+void free_cb_data(struct vspm_if_cb_data_t *cb_data);
 void set_cb_rsp_vsp(
 	struct vspm_if_cb_data_t *cb_data,
 	struct vspm_if_entry_data_t *entry_data);
@@ -215,8 +460,62 @@ int set_fdp_par(
 	struct vspm_if_entry_data_t *entry,
 	struct fdp_start_t *fdp_par);
 
-int set_compat_vsp_par(struct vspm_if_entry_data_t *entry, unsigned int src);
-int set_compat_fdp_par(struct vspm_if_entry_data_t *entry, unsigned int src);
+int set_compat_vsp_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_if_entry_data_t *entry,
+	unsigned int src);
+int set_compat_fdp_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_if_entry_data_t *entry,
+	unsigned int src);
+int set_compat_job_par(
+	struct vspm_if_entry_data_t *entry_data,
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_compat_job_t *compat_job);
+
+int set_tmpl_par(
+	struct vspm_if_entry_data_t *entry,
+	const struct vspm_if_entry_data_t *tmpl,
+	const struct vspm_if_tmpl_entry_req_t *req);
+void put_tmpl(struct vspm_if_tmpl_t *tmpl);
+void release_all_tmpl(struct vspm_if_private_t *priv);
+
+struct vspm_if_tbl_t *alloc_tbl(
+	const void __user *tbl_addr, unsigned int tbl_num);
+void put_tbl(struct vspm_if_tbl_t *tbl);
+void release_all_tbl(struct vspm_if_private_t *priv);
+void flush_deferred_free(void);
+
+struct vspm_if_dmabuf_t *import_dmabuf(struct dma_buf *dmabuf);
+void release_dmabuf(struct vspm_if_dmabuf_t *buf);
+void release_all_dmabuf(struct vspm_if_private_t *priv);
+int retire_after_jobs(
+	struct vspm_if_private_t *priv, unsigned long long *seq, int counted);
+void release_retired_work(struct work_struct *work);
+
+struct vspm_if_buf_table_t *alloc_buf_table(
+	const int __user *fds, unsigned int num);
+void put_buf_table(struct vspm_if_buf_table_t *table);
+struct dma_buf *alloc_export_buf(size_t size);
+int set_fixed_buf_addr(
+	const struct vspm_if_buf_table_t *table,
+	unsigned int index,
+	struct vspm_if_tmpl_addr_t *addr,
+	const struct vspm_if_plane_size_t *plane);
+
+struct vspm_if_uptr_t *alloc_uptr(unsigned long user_addr, unsigned int size);
+void release_uptr(struct vspm_if_uptr_t *uptr);
+void release_all_uptr(struct vspm_if_private_t *priv);
+
+struct dma_fence *alloc_out_fence(void);
+void signal_out_fence(struct dma_fence **fence, int error);
+struct vspm_if_in_fence_t *alloc_in_fence(
+	const int __user *fds,
+	unsigned int num,
+	struct dma_fence **deps,
+	unsigned int dep_num);
+void free_in_fence(struct vspm_if_in_fence_t *in_fence);
+void release_all_in_fence(struct vspm_if_private_t *priv);
 
 #endif /* __VSPM_IF_LOCAL_H__ */
 
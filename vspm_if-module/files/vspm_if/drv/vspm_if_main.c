@@ -64,12 +64,24 @@
 #include <linux/dma-mapping.h>
 #include <linux/fs.h>
 #include <linux/ioctl.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/kthread.h>
+#include <linux/log2.h>
+#include <linux/poll.h>
+#include <linux/compat.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
+#include <linux/sync_file.h>
 
 #include "vspm_public.h"
 #include "vspm_if.h"
 #include "vspm_if_local.h"
 
 struct platform_device *g_vspmif_pdev;
+struct kmem_cache *g_vspmif_entry_cache;
+
+static void in_fence_work(struct work_struct *work);
 
 static int open(struct inode *inode, struct file *file)
 {
@@ -84,9 +96,27 @@ static int open(struct inode *inode, struct file *file)
 	spin_lock_init(&priv->lock);
 	init_completion(&priv->wait_interrupt);
 	init_completion(&priv->wait_thread);
+	init_waitqueue_head(&priv->poll_wait);
 	INIT_LIST_HEAD(&priv->entry_data.list);
 	INIT_LIST_HEAD(&priv->cb_data.list);
+	INIT_LIST_HEAD(&priv->entry_pool.list);
 	sema_init(&priv->sem, 1);
+	spin_lock_init(&priv->work_pool.lock);
+	INIT_LIST_HEAD(&priv->work_pool.free);
+	mutex_init(&priv->tmpl_lock);
+	idr_init(&priv->tmpl_idr);
+	mutex_init(&priv->tbl_lock);
+	idr_init(&priv->tbl_idr);
+	mutex_init(&priv->dmabuf_lock);
+	idr_init(&priv->dmabuf_idr);
+	INIT_LIST_HEAD(&priv->dmabuf_retire);
+	mutex_init(&priv->uptr_lock);
+	INIT_LIST_HEAD(&priv->uptr_lru);
+	INIT_LIST_HEAD(&priv->uptr_retire);
+	INIT_LIST_HEAD(&priv->in_fence_list);
+	INIT_WORK(&priv->fence_work, in_fence_work);
+	INIT_WORK(&priv->retire_work, release_retired_work);
+	mutex_init(&priv->ring_lock);
 
 	file->private_data = priv;
 	return 0;
@@ -98,67 +128,2355 @@ static int close(struct inode *inode, struct file *file)
 		(struct vspm_if_private_t *)file->private_data;
 
 	if (priv) {
+		/* release submission queue */
+		release_sq(priv);
+
+		/* release jobs waiting for in-fences */
+		release_all_in_fence(priv);
+
 		if (priv->handle) {
 			(void)vspm_quit_driver(priv->handle);
 			priv->handle = NULL;
 		}
 
+		if (priv->pipe_handle) {
+			(void)vspm_quit_driver(priv->pipe_handle);
+			priv->pipe_handle = NULL;
+		}
+
 		/* release entry data */
 		release_all_entry_data(priv);
 
 		/* release callback data */
 		release_all_cb_data(priv);
 
-		/* release work buffer */
-		release_work_buffers(priv);
+		/* release job templates */
+		release_all_tmpl(priv);
+
+		/* release table cache */
+		release_all_tbl(priv);
+
+		/* release imported dma-buf */
+		release_all_dmabuf(priv);
+
+		/* release user pointer mappings */
+		release_all_uptr(priv);
+
+		/* release entry data pool */
+		release_entry_pool(priv);
+
+		/* release completion queue */
+		release_cq(priv);
+
+		/* release work buffer */
+		release_work_buffers(priv);
+
+		/* release memory */
+		kfree(priv);
+	}
+
+	file->private_data = NULL;
+	return 0;
+}
+
+static int set_handle(
+	struct vspm_if_private_t *priv, void *handle, unsigned short type)
+{
+	/* preallocate entry data */
+	if (init_entry_pool(priv)) {
+		(void)vspm_quit_driver(handle);
+		return -ENOMEM;
+	}
+
+	/* size of display list */
+	if (priv->config.dl_size > VSPM_IF_DL_SIZE_MIN)
+		priv->work_pool.dl_size = priv->config.dl_size;
+	else
+		priv->work_pool.dl_size = 0;
+
+	priv->handle = handle;
+	priv->type = type;
+	return 0;
+}
+
+static long vspm_ioctl_init(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_init_t init_par;
+	struct vspm_init_fdp_t init_fdp_par;
+
+	void *handle;
+	long ercd;
+
+	/* copy initialize parameter */
+	if (copy_from_user(
+			&init_par, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("INIT: failed to copy from user!!\n");
+		return -EFAULT;
+	}
+
+	switch (init_par.type) {
+	case VSPM_TYPE_VSP_AUTO:
+		/* initialize parameter is not used */
+		init_par.par.vsp = NULL;
+		break;
+	case VSPM_TYPE_FDP_AUTO:
+		/* copy initialize parameter of FDP */
+		if (init_par.par.fdp) {
+			if (copy_from_user(
+					&init_fdp_par,
+					(void __user *)init_par.par.fdp,
+					sizeof(struct vspm_init_fdp_t))) {
+				EPRINT("INIT: failed to copy FDP param\n");
+				return -EFAULT;
+			}
+			init_par.par.fdp = &init_fdp_par;
+		}
+		break;
+	default:
+		break;
+	}
+
+	/* initialize VSP manager */
+	ercd = vspm_init_driver(&handle, &init_par);
+	switch (ercd) {
+	case R_VSPM_OK:
+		break;
+	case R_VSPM_PARAERR:
+		return -EINVAL;
+	case R_VSPM_ALREADY_USED:
+		return -EBUSY;
+	default:
+		return -EFAULT;
+	}
+
+	return set_handle(priv, handle, init_par.type);
+}
+
+static long vspm_ioctl_quit(struct vspm_if_private_t *priv)
+{
+	long ercd;
+
+	/* release jobs waiting for in-fences */
+	release_all_in_fence(priv);
+
+	/* finalize VSP manager */
+	ercd = vspm_quit_driver(priv->handle);
+	if (ercd != R_VSPM_OK)
+		return -EFAULT;
+
+	priv->handle = NULL;
+
+	if (priv->pipe_handle) {
+		(void)vspm_quit_driver(priv->pipe_handle);
+		priv->pipe_handle = NULL;
+	}
+
+	/* release entry data */
+	release_all_entry_data(priv);
+	release_entry_pool(priv);
+
+	return 0;
+}
+
+static void notify_cb_data(struct vspm_if_private_t *priv)
+{
+	complete(&priv->wait_interrupt);
+	wake_up_interruptible(&priv->poll_wait);
+}
+
+static int cq_post(
+	struct vspm_if_private_t *priv, const struct vspm_if_cb_rsp_t *rsp)
+{
+	struct vspm_if_cq_t *cq = priv->cq;
+	struct vspm_if_cqe_t *cqe;
+	unsigned long lock_flag;
+
+	unsigned int head;
+
+	spin_lock_irqsave(&priv->lock, lock_flag);
+
+	/* check free space */
+	head = smp_load_acquire(&cq->ring->head);
+	if (cq->tail - head >= cq->entries) {
+		cq->ring->overflow++;
+		spin_unlock_irqrestore(&priv->lock, lock_flag);
+		return -ENOSPC;
+	}
+
+	/* write entry */
+	cqe = &cq->cqes[cq->tail & (cq->entries - 1)];
+	cqe->job_id = rsp->job_id;
+	cqe->user_data = (unsigned long)rsp->user_data;
+	cqe->cb_func = (unsigned long)rsp->cb_func;
+	cqe->result = rsp->result;
+
+	cq->tail++;
+	smp_store_release(&cq->ring->tail, cq->tail);
+
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+
+	wake_up(&cq->wait);
+
+	return 0;
+}
+
+static int has_hist_result(struct vspm_if_entry_data_t *entry_data)
+{
+	struct vspm_entry_vsp *vsp = &entry_data->ip_par.vsp;
+
+	if (entry_data->job.type != VSPM_TYPE_VSP_AUTO)
+		return 0;
+
+	if (vsp->ctrl.hgo.hgo.virt_addr && vsp->ctrl.hgo.user_addr)
+		return 1;
+
+	if (vsp->ctrl.hgt.hgt.virt_addr && vsp->ctrl.hgt.user_addr)
+		return 1;
+
+	return 0;
+}
+
+static void vspm_cb_func(
+	unsigned long job_id, long result, void *user_data)
+{
+	struct vspm_if_entry_data_t *entry_data =
+		(struct vspm_if_entry_data_t *)user_data;
+
+	struct vspm_if_private_t *priv;
+	struct vspm_if_cb_data_t *cb_data;
+	struct vspm_if_cb_rsp_t rsp;
+	struct vspm_if_tmpl_t *tmpl;
+	struct vspm_if_buf_table_t *buf_table;
+	unsigned long lock_flag;
+	unsigned int retire;
+
+	if (!entry_data)
+		return;
+
+	priv = entry_data->priv;
+
+	/* del list */
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	list_del(&entry_data->list);
+	retire = priv->retire_num;
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+
+	/* buffers released while the job ran */
+	if (retire)
+		schedule_work(&priv->retire_work);
+
+	/* make response data */
+	rsp.ercd = 0;
+	rsp.cb_func = entry_data->entry.req.cb_func;
+	rsp.job_id = job_id;
+	rsp.result = result;
+	rsp.user_data = entry_data->entry.req.user_data;
+
+	/* signal out-fence */
+	signal_out_fence(&entry_data->fence, result == R_VSPM_OK ? 0 : -EIO);
+
+	/* write to completion queue */
+	/* (histogram results are copied to user by WAIT_INTERRUPT) */
+	if (priv->cq && !has_hist_result(entry_data) &&
+	    !cq_post(priv, &rsp)) {
+		/* release memory */
+		if (entry_data->job.type == VSPM_TYPE_VSP_AUTO)
+			free_vsp_par(&entry_data->ip_par.vsp);
+		put_tmpl(entry_data->tmpl);
+		put_buf_table(entry_data->buf_table);
+		put_entry_data(entry_data);
+		return;
+	}
+
+	/* callback data is embedded in entry data */
+	cb_data = &entry_data->cb_data;
+	cb_data->rsp = rsp;
+
+	if (entry_data->job.type == VSPM_TYPE_VSP_AUTO) {
+		/* set callback response of vsp */
+		set_cb_rsp_vsp(cb_data, entry_data);
+	}
+
+	/* entry data may be freed by the reader once it is listed */
+	tmpl = entry_data->tmpl;
+	entry_data->tmpl = NULL;
+	buf_table = entry_data->buf_table;
+	entry_data->buf_table = NULL;
+
+	/* addition list */
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	list_add_tail(&cb_data->list, &priv->cb_data.list);
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+
+	notify_cb_data(priv);
+
+	put_tmpl(tmpl);
+	put_buf_table(buf_table);
+}
+
+static struct vspm_if_entry_data_t *alloc_entry_data(
+	struct vspm_if_private_t *priv)
+{
+	struct vspm_if_entry_data_t *entry_data;
+	unsigned long lock_flag;
+
+	/* get entry data from pool */
+	entry_data = get_entry_data(priv);
+	if (!entry_data)
+		return NULL;
+
+	/* add list (the list is kept in the order of seq) */
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	entry_data->seq = priv->job_seq++;
+	list_add_tail(&entry_data->list, &priv->entry_data.list);
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+
+	return entry_data;
+}
+
+static void free_entry_data(struct vspm_if_entry_data_t *entry_data)
+{
+	struct vspm_if_private_t *priv = entry_data->priv;
+	unsigned long lock_flag;
+	unsigned int retire;
+
+	/* del list */
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	list_del(&entry_data->list);
+	retire = priv->retire_num;
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+
+	/* buffers released while the job was queued */
+	if (retire)
+		schedule_work(&priv->retire_work);
+
+	/* release memory */
+	if (entry_data->job.type == VSPM_TYPE_VSP_AUTO)
+		free_vsp_par(&entry_data->ip_par.vsp);
+	put_tmpl(entry_data->tmpl);
+	put_buf_table(entry_data->buf_table);
+	signal_out_fence(&entry_data->fence, -ECANCELED);
+	put_entry_data(entry_data);
+}
+
+static void sq_post_error(
+	struct vspm_if_private_t *priv,
+	unsigned long long user_data,
+	unsigned long long cb_func,
+	long result)
+{
+	struct vspm_if_entry_data_t *entry_data;
+	struct vspm_if_cb_rsp_t rsp;
+	unsigned long lock_flag;
+
+	/* make response data */
+	rsp.ercd = 0;
+	rsp.cb_func = VSPM_IF_INT_TO_CP(cb_func);
+	rsp.job_id = 0;
+	rsp.result = result;
+	rsp.user_data = VSPM_IF_INT_TO_VP(user_data);
+
+	/* write to completion queue */
+	if (priv->cq && !cq_post(priv, &rsp))
+		return;
+
+	/* record reserved before the entry was consumed */
+	entry_data = priv->sq->err_rec;
+	priv->sq->err_rec = NULL;
+	entry_data->cb_data.rsp = rsp;
+
+	/* addition list */
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	list_add_tail(&entry_data->cb_data.list, &priv->cb_data.list);
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+
+	notify_cb_data(priv);
+}
+
+static void *job_handle(
+	struct vspm_if_private_t *priv,
+	const struct vspm_if_entry_data_t *entry_data)
+{
+	/* VSP jobs of a pipeline fd go to the second handle */
+	if (priv->pipe_handle &&
+	    entry_data->job.type == VSPM_TYPE_VSP_AUTO)
+		return priv->pipe_handle;
+
+	return priv->handle;
+}
+
+static void in_fence_signaled(
+	struct vspm_if_in_fence_t *in_fence, struct dma_fence *fence)
+{
+	struct vspm_if_private_t *priv = in_fence->entry_data->priv;
+
+	if (fence->error)
+		in_fence->error = fence->error;
+
+	if (atomic_dec_and_test(&in_fence->pending))
+		schedule_work(&priv->fence_work);
+}
+
+static void in_fence_cb(struct dma_fence *fence, struct dma_fence_cb *cb)
+{
+	struct vspm_if_fence_wait_t *wait =
+		container_of(cb, struct vspm_if_fence_wait_t, cb);
+
+	in_fence_signaled(wait->in_fence, fence);
+}
+
+static void arm_in_fence(
+	struct vspm_if_in_fence_t *in_fence,
+	struct vspm_if_entry_data_t *entry_data)
+{
+	struct vspm_if_private_t *priv = entry_data->priv;
+	struct vspm_if_fence_wait_t *wait;
+
+	unsigned long lock_flag;
+	unsigned int i;
+
+	in_fence->entry_data = entry_data;
+
+	/* keep one until all callbacks are added */
+	atomic_set(&in_fence->pending, in_fence->num + 1);
+
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	list_add_tail(&in_fence->list, &priv->in_fence_list);
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+
+	for (i = 0; i < in_fence->num; i++) {
+		wait = &in_fence->wait[i];
+		if (dma_fence_add_callback(wait->fence, &wait->cb, in_fence_cb))
+			in_fence_signaled(in_fence, wait->fence);
+	}
+
+	if (atomic_dec_and_test(&in_fence->pending))
+		schedule_work(&priv->fence_work);
+}
+
+static void in_fence_work(struct work_struct *work)
+{
+	struct vspm_if_private_t *priv =
+		container_of(work, struct vspm_if_private_t, fence_work);
+	struct vspm_if_in_fence_t *in_fence;
+	struct vspm_if_in_fence_t *ready;
+	struct vspm_if_entry_data_t *entry_data;
+	struct vspm_if_entry_req_t *entry_req;
+
+	unsigned long lock_flag;
+	unsigned long job_id;
+	long ercd;
+
+	for (;;) {
+		/* take a job whose in-fences are all signaled */
+		ready = NULL;
+		spin_lock_irqsave(&priv->lock, lock_flag);
+		list_for_each_entry(in_fence, &priv->in_fence_list, list) {
+			if (!atomic_read(&in_fence->pending)) {
+				list_del(&in_fence->list);
+				ready = in_fence;
+				break;
+			}
+		}
+		spin_unlock_irqrestore(&priv->lock, lock_flag);
+		if (!ready)
+			break;
+
+		entry_data = ready->entry_data;
+		entry_req = &entry_data->entry.req;
+
+		/* entry job */
+		ercd = R_VSPM_NG;
+		if (!ready->error) {
+			ercd = vspm_entry_job(
+				job_handle(priv, entry_data),
+				&job_id,
+				entry_req->priority,
+				entry_req->job_param,
+				(void *)entry_data,
+				vspm_cb_func);
+		}
+
+		/* report the job that could not be entried */
+		if (ercd != R_VSPM_OK) {
+			sq_post_error(
+				priv,
+				(unsigned long)entry_req->user_data,
+				(unsigned long)entry_req->cb_func,
+				ercd);
+			free_entry_data(entry_data);
+		}
+
+		free_in_fence(ready);
+	}
+}
+
+static long entry_job(
+	struct vspm_if_private_t *priv,
+	struct vspm_if_entry_data_t *entry_data,
+	struct vspm_if_in_fence_t *in_fence,
+	unsigned long *job_id)
+{
+	struct vspm_if_entry_req_t *entry_req = &entry_data->entry.req;
+
+	/* entry after the in-fences are signaled */
+	if (in_fence) {
+		arm_in_fence(in_fence, entry_data);
+		*job_id = 0;
+		return R_VSPM_OK;
+	}
+
+	return vspm_entry_job(
+		job_handle(priv, entry_data),
+		job_id,
+		entry_req->priority,
+		entry_req->job_param,
+		(void *)entry_data,
+		vspm_cb_func);
+}
+
+static int set_entry_par(struct vspm_if_entry_data_t *entry_data)
+{
+	struct vspm_if_entry_req_t *entry_req = &entry_data->entry.req;
+	int ercd;
+
+	if (!entry_req->job_param)
+		return 0;
+
+	/* copy job parameter */
+	if (copy_from_user(
+			&entry_data->job,
+			(void __user *)entry_req->job_param,
+			sizeof(struct vspm_job_t))) {
+		EPRINT("ENTRY: failed to copy the job parameter\n");
+		return -EFAULT;
+	}
+	entry_req->job_param = &entry_data->job;
+
+	switch (entry_data->job.type) {
+	case VSPM_TYPE_VSP_AUTO:
+		if (entry_data->job.par.vsp) {
+			/* copy start parameter of VSP */
+			ercd = set_vsp_par(entry_data, entry_data->job.par.vsp);
+			if (ercd)
+				return ercd;
+
+			entry_req->job_param->par.vsp =
+				&entry_data->ip_par.vsp.par;
+		}
+		break;
+	case VSPM_TYPE_FDP_AUTO:
+		if (entry_data->job.par.fdp) {
+			/* copy start parameter of FDP */
+			ercd = set_fdp_par(entry_data, entry_data->job.par.fdp);
+			if (ercd)
+				return ercd;
+
+			entry_req->job_param->par.fdp =
+				&entry_data->ip_par.fdp.par;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+static int entry_one(
+	struct vspm_if_private_t *priv, struct vspm_if_entry_t *entry)
+{
+	struct vspm_if_entry_data_t *entry_data;
+	struct vspm_if_entry_req_t *entry_req;
+
+	int ercd;
+
+	/* allocate entry data */
+	entry_data = alloc_entry_data(priv);
+	if (!entry_data)
+		return -ENOMEM;
+
+	entry_data->entry.req = entry->req;
+	entry_req = &entry_data->entry.req;
+
+	/* copy job parameter */
+	ercd = set_entry_par(entry_data);
+	if (ercd)
+		goto err_exit;
+
+	/* entry job */
+	entry->rsp.ercd = vspm_entry_job(
+		job_handle(priv, entry_data),
+		&entry->rsp.job_id,
+		entry_req->priority,
+		entry_req->job_param,
+		(void *)entry_data,
+		vspm_cb_func);
+	if (entry->rsp.ercd != R_VSPM_OK)
+		goto err_exit;
+
+	return 0;
+
+err_exit:
+	free_entry_data(entry_data);
+	return ercd;
+}
+
+static long vspm_ioctl_entry(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_entry_t entry;
+	int ercd;
+
+	/* copy entry parameter */
+	if (copy_from_user(&entry, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("ENTRY: failed to copy the entry parameter\n");
+		return -EFAULT;
+	}
+
+	/* entry job */
+	ercd = entry_one(priv, &entry);
+	if (ercd)
+		return ercd;
+
+	/* copy result to user */
+	if (copy_to_user(
+			(void __user *)arg, &entry, _IOC_SIZE(cmd)))
+		APRINT("ENTRY: failed to copy the result\n");
+
+	return 0;
+}
+
+static long vspm_ioctl_entry_batch(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_entry_batch_t batch;
+	struct vspm_if_entry_t *entry;
+
+	unsigned int i;
+	int ercd = 0;
+
+	/* copy batch parameter */
+	if (copy_from_user(&batch, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("BATCH: failed to copy the batch parameter\n");
+		return -EFAULT;
+	}
+
+	if (batch.num == 0 || batch.num > VSPM_IF_ENTRY_BATCH_MAX)
+		return -EINVAL;
+
+	entry = kmalloc_array(
+		batch.num, sizeof(struct vspm_if_entry_t), GFP_KERNEL);
+	if (!entry)
+		return -ENOMEM;
+
+	/* copy entry parameters at once */
+	if (copy_from_user(
+			entry,
+			(void __user *)batch.entry,
+			batch.num * sizeof(struct vspm_if_entry_t))) {
+		EPRINT("BATCH: failed to copy the entry parameter\n");
+		kfree(entry);
+		return -EFAULT;
+	}
+
+	/* entry jobs until the first failure */
+	for (i = 0; i < batch.num; i++) {
+		ercd = entry_one(priv, &entry[i]);
+		if (ercd)
+			break;
+		if (entry[i].rsp.ercd != R_VSPM_OK) {
+			i++;
+			break;
+		}
+	}
+	batch.done = i;
+
+	/* copy results to user */
+	if (batch.done) {
+		if (copy_to_user(
+				(void __user *)batch.entry,
+				entry,
+				batch.done * sizeof(struct vspm_if_entry_t)))
+			APRINT("BATCH: failed to copy the result\n");
+	}
+	if (copy_to_user((void __user *)arg, &batch, _IOC_SIZE(cmd)))
+		APRINT("BATCH: failed to copy the result\n");
+
+	kfree(entry);
+	return ercd;
+}
+
+static int entry_job_v2(
+	struct vspm_if_private_t *priv,
+	struct vspm_if_entry_v2_t *entry,
+	struct vspm_if_job_v2_t *job,
+	struct dma_fence *fence,
+	struct vspm_if_in_fence_t *in_fence)
+{
+	struct vspm_if_entry_v2_req_t *req = &entry->req;
+	struct vspm_if_entry_data_t *entry_data;
+	struct vspm_if_entry_req_t *entry_req;
+	struct vspm_if_par_src_t psrc;
+
+	unsigned long job_id = 0;
+	int ercd;
+
+	psrc.desc = job;
+	psrc.size = req->job_size;
+
+	/* allocate entry data */
+	entry_data = alloc_entry_data(priv);
+	if (!entry_data)
+		return -ENOMEM;
+
+	entry_data->fence = dma_fence_get(fence);
+
+	entry_req = &entry_data->entry.req;
+	entry_req->priority = req->priority;
+	entry_req->user_data = VSPM_IF_INT_TO_VP(req->user_data);
+	entry_req->cb_func = VSPM_IF_INT_TO_CP(req->cb_func);
+
+	/* set job parameter from descriptor */
+	ercd = set_compat_job_par(entry_data, &psrc, &job->job);
+	if (ercd)
+		goto err_exit;
+
+	if (entry_data->job.type == VSPM_TYPE_VSP_AUTO) {
+		/* destination of histogram results */
+		entry_data->ip_par.vsp.ctrl.hgo.user_addr =
+			VSPM_IF_INT_TO_VP(req->hgo_addr);
+		entry_data->ip_par.vsp.ctrl.hgt.user_addr =
+			VSPM_IF_INT_TO_VP(req->hgt_addr);
+	}
+
+	/* entry job */
+	entry->rsp.ercd = entry_job(priv, entry_data, in_fence, &job_id);
+	entry->rsp.job_id = job_id;
+	if (entry->rsp.ercd != R_VSPM_OK)
+		goto err_exit;
+
+	return 0;
+
+err_exit:
+	free_entry_data(entry_data);
+	return ercd;
+}
+
+static int entry_one_v2(
+	struct vspm_if_private_t *priv,
+	struct vspm_if_entry_v2_t *entry,
+	struct dma_fence *fence,
+	struct vspm_if_in_fence_t *in_fence)
+{
+	struct vspm_if_entry_v2_req_t *req = &entry->req;
+	struct vspm_if_job_v2_t *job;
+
+	int ercd;
+
+	if (req->job_size < sizeof(struct vspm_if_job_v2_t) ||
+	    req->job_size > VSPM_IF_JOB_V2_MAX_SIZE)
+		return -EINVAL;
+
+	/* copy job descriptor at once */
+	job = kmalloc(req->job_size, GFP_KERNEL);
+	if (!job)
+		return -ENOMEM;
+
+	if (copy_from_user(
+			job,
+			VSPM_IF_INT_TO_UP(req->job_param),
+			req->job_size)) {
+		EPRINT("ENTRY_V2: failed to copy the job descriptor\n");
+		kfree(job);
+		return -EFAULT;
+	}
+
+	/* entry job */
+	ercd = entry_job_v2(priv, entry, job, fence, in_fence);
+	kfree(job);
+
+	return ercd;
+}
+
+static long vspm_ioctl_entry_v2(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_entry_v2_t entry;
+	int ercd;
+
+	/* copy entry parameter */
+	if (copy_from_user(&entry, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("ENTRY_V2: failed to copy the entry parameter\n");
+		return -EFAULT;
+	}
+
+	/* entry job */
+	ercd = entry_one_v2(priv, &entry, NULL, NULL);
+	if (ercd)
+		return ercd;
+
+	/* copy result to user */
+	if (copy_to_user(
+			(void __user *)arg, &entry, _IOC_SIZE(cmd)))
+		APRINT("ENTRY_V2: failed to copy the result\n");
+
+	return 0;
+}
+
+static long vspm_ioctl_tmpl_register(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_tmpl_reg_t reg;
+	struct vspm_if_tmpl_t *tmpl;
+	struct vspm_if_job_v2_t *job;
+	struct vspm_if_par_src_t psrc;
+
+	int ercd;
+
+	/* copy register parameter */
+	if (copy_from_user(&reg, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("TMPL: failed to copy the register parameter\n");
+		return -EFAULT;
+	}
+
+	if (reg.job_size < sizeof(struct vspm_if_job_v2_t) ||
+	    reg.job_size > VSPM_IF_JOB_V2_MAX_SIZE)
+		return -EINVAL;
+
+	/* copy job descriptor at once */
+	job = kmalloc(reg.job_size, GFP_KERNEL);
+	if (!job)
+		return -ENOMEM;
+
+	if (copy_from_user(
+			job,
+			VSPM_IF_INT_TO_UP(reg.job_param),
+			reg.job_size)) {
+		EPRINT("TMPL: failed to copy the job descriptor\n");
+		kfree(job);
+		return -EFAULT;
+	}
+
+	if (job->job.type != VSPM_TYPE_VSP_AUTO &&
+	    job->job.type != VSPM_TYPE_FDP_AUTO) {
+		kfree(job);
+		return -EINVAL;
+	}
+
+	/* allocate template */
+	tmpl = kzalloc(sizeof(struct vspm_if_tmpl_t), GFP_KERNEL);
+	if (!tmpl) {
+		kfree(job);
+		return -ENOMEM;
+	}
+	kref_init(&tmpl->ref);
+	tmpl->entry_data.priv = priv;
+
+	/* set job parameter from descriptor */
+	psrc.desc = job;
+	psrc.size = reg.job_size;
+
+	ercd = set_compat_job_par(&tmpl->entry_data, &psrc, &job->job);
+	kfree(job);
+	if (ercd)
+		goto err_exit;
+
+	/* register template */
+	mutex_lock(&priv->tmpl_lock);
+	ercd = idr_alloc(&priv->tmpl_idr, tmpl, 1, 0, GFP_KERNEL);
+	mutex_unlock(&priv->tmpl_lock);
+	if (ercd < 0)
+		goto err_exit;
+
+	reg.id = (unsigned int)ercd;
+
+	/* copy result to user */
+	if (copy_to_user((void __user *)arg, &reg, _IOC_SIZE(cmd))) {
+		EPRINT("TMPL: failed to copy the result\n");
+		mutex_lock(&priv->tmpl_lock);
+		idr_remove(&priv->tmpl_idr, reg.id);
+		mutex_unlock(&priv->tmpl_lock);
+		put_tmpl(tmpl);
+		return -EFAULT;
+	}
+
+	return 0;
+
+err_exit:
+	put_tmpl(tmpl);
+	return ercd;
+}
+
+static long vspm_ioctl_tmpl_unregister(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_tmpl_t *tmpl;
+	unsigned int id;
+
+	/* copy template id */
+	if (copy_from_user(&id, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("TMPL: failed to copy the template id\n");
+		return -EFAULT;
+	}
+
+	/* unregister template */
+	mutex_lock(&priv->tmpl_lock);
+	tmpl = idr_remove(&priv->tmpl_idr, id);
+	mutex_unlock(&priv->tmpl_lock);
+	if (!tmpl)
+		return -ENOENT;
+
+	/* the template is released after the last job referencing it */
+	put_tmpl(tmpl);
+
+	return 0;
+}
+
+static int get_fixed_buf_plane(
+	const struct vspm_if_entry_data_t *tmpl,
+	int i,
+	struct vspm_if_plane_size_t *plane)
+{
+	const struct vsp_src_t *src;
+	const struct vsp_dst_t *dst;
+	const struct fdp_fproc_t *fproc;
+	const struct fdp_imgbuf_t *buf = NULL;
+
+	if (tmpl->job.type == VSPM_TYPE_VSP_AUTO) {
+		/* (4:2:0 is assumed for the height of chroma planes) */
+		if (i < 5) {
+			if (!tmpl->ip_par.vsp.par.src_par[i])
+				return -EINVAL;
+			src = &tmpl->ip_par.vsp.in[i].in;
+			plane->size =
+				(unsigned long long)src->stride * src->height;
+			plane->size_c = (unsigned long long)src->stride_c *
+				DIV_ROUND_UP(src->height, 2);
+		} else {
+			if (!tmpl->ip_par.vsp.par.dst_par)
+				return -EINVAL;
+			dst = &tmpl->ip_par.vsp.out.out;
+			plane->size =
+				(unsigned long long)dst->stride * dst->height;
+			plane->size_c = (unsigned long long)dst->stride_c *
+				DIV_ROUND_UP(dst->height, 2);
+		}
+		return 0;
+	}
+
+	/* FDP has the height of chroma planes */
+	if (tmpl->ip_par.fdp.par.fproc_par) {
+		fproc = &tmpl->ip_par.fdp.fproc.fproc;
+		if (i == 0)
+			buf = fproc->out_buf;
+		else if (fproc->ref_buf && i == 1)
+			buf = fproc->ref_buf->next_buf;
+		else if (fproc->ref_buf && i == 2)
+			buf = fproc->ref_buf->cur_buf;
+		else if (fproc->ref_buf && i == 3)
+			buf = fproc->ref_buf->prev_buf;
+	}
+	if (!buf)
+		return -EINVAL;
+
+	plane->size = (unsigned long long)buf->stride * buf->height;
+	plane->size_c = (unsigned long long)buf->stride_c * buf->height_c;
+	return 0;
+}
+
+static int set_fixed_buf_req(
+	struct vspm_if_entry_data_t *entry_data,
+	const struct vspm_if_tmpl_t *tmpl,
+	struct vspm_if_tmpl_entry_req_t *req)
+{
+	struct vspm_if_private_t *priv = entry_data->priv;
+	struct vspm_if_buf_table_t *table;
+	struct vspm_if_tmpl_addr_t *addr;
+	struct vspm_if_plane_size_t plane;
+
+	unsigned int patch;
+	int ercd;
+	int i;
+
+	/* get fixed buffer table */
+	mutex_lock(&priv->dmabuf_lock);
+	table = priv->buf_table;
+	if (table)
+		kref_get(&table->ref);
+	mutex_unlock(&priv->dmabuf_lock);
+	if (!table)
+		return -ENOENT;
+
+	/* the table is kept until the job is done */
+	entry_data->buf_table = table;
+
+	/* convert offsets to addresses */
+	for (i = 0; i < VSPM_IF_TMPL_FIXED_BUF_NUM; i++) {
+		if (tmpl->entry_data.job.type == VSPM_TYPE_VSP_AUTO) {
+			if (i < 5) {
+				patch = VSPM_IF_TMPL_PATCH_SRC(i);
+				addr = &req->src[i];
+			} else {
+				patch = VSPM_IF_TMPL_PATCH_DST;
+				addr = &req->dst;
+			}
+		} else {
+			if (i == 0) {
+				patch = VSPM_IF_TMPL_PATCH_FDP_OUT;
+				addr = &req->fdp_out;
+			} else if (i < 4) {
+				patch = VSPM_IF_TMPL_PATCH_FDP_REF(i - 1);
+				addr = &req->fdp_ref[i - 1];
+			} else {
+				break;
+			}
+		}
+
+		if (!(req->patch & patch))
+			continue;
+
+		/* extent of the image to be in the buffer */
+		ercd = get_fixed_buf_plane(&tmpl->entry_data, i, &plane);
+		if (ercd)
+			return ercd;
+
+		ercd = set_fixed_buf_addr(
+			table, req->buf_index[i], addr, &plane);
+		if (ercd)
+			return ercd;
+	}
+
+	return 0;
+}
+
+static int entry_one_tmpl(
+	struct vspm_if_private_t *priv,
+	struct vspm_if_tmpl_entry_t *entry,
+	struct dma_fence *fence,
+	struct vspm_if_in_fence_t *in_fence)
+{
+	struct vspm_if_tmpl_entry_req_t *req = &entry->req;
+	struct vspm_if_tmpl_entry_req_t fixed_req;
+	struct vspm_if_entry_data_t *entry_data;
+	struct vspm_if_entry_req_t *entry_req;
+	struct vspm_if_tmpl_t *tmpl;
+
+	unsigned long job_id = 0;
+	int ercd;
+
+	/* find template */
+	mutex_lock(&priv->tmpl_lock);
+	tmpl = idr_find(&priv->tmpl_idr, req->id);
+	if (tmpl)
+		kref_get(&tmpl->ref);
+	mutex_unlock(&priv->tmpl_lock);
+	if (!tmpl)
+		return -ENOENT;
+
+	/* allocate entry data */
+	entry_data = alloc_entry_data(priv);
+	if (!entry_data) {
+		put_tmpl(tmpl);
+		return -ENOMEM;
+	}
+	entry_data->tmpl = tmpl;
+
+	entry_data->fence = dma_fence_get(fence);
+
+	entry_req = &entry_data->entry.req;
+	entry_req->priority = req->priority;
+	entry_req->user_data = VSPM_IF_INT_TO_VP(req->user_data);
+	entry_req->cb_func = VSPM_IF_INT_TO_CP(req->cb_func);
+
+	/* addresses in the fixed buffer table */
+	if (req->patch & VSPM_IF_TMPL_PATCH_FIXED_BUF) {
+		fixed_req = *req;
+		ercd = set_fixed_buf_req(entry_data, tmpl, &fixed_req);
+		if (ercd)
+			goto err_exit;
+		req = &fixed_req;
+	}
+
+	/* set job parameter from template */
+	ercd = set_tmpl_par(entry_data, &tmpl->entry_data, req);
+	if (ercd)
+		goto err_exit;
+
+	/* entry job */
+	entry->rsp.ercd = entry_job(priv, entry_data, in_fence, &job_id);
+	entry->rsp.job_id = job_id;
+	if (entry->rsp.ercd != R_VSPM_OK)
+		goto err_exit;
+
+	return 0;
+
+err_exit:
+	free_entry_data(entry_data);
+	return ercd;
+}
+
+static long vspm_ioctl_tmpl_entry(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_tmpl_entry_t entry;
+	int ercd;
+
+	/* copy entry parameter */
+	if (copy_from_user(&entry, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("TMPL: failed to copy the entry parameter\n");
+		return -EFAULT;
+	}
+
+	/* entry job */
+	ercd = entry_one_tmpl(priv, &entry, NULL, NULL);
+	if (ercd)
+		return ercd;
+
+	/* copy result to user */
+	if (copy_to_user(
+			(void __user *)arg, &entry, _IOC_SIZE(cmd)))
+		APRINT("TMPL: failed to copy the result\n");
+
+	return 0;
+}
+
+static void install_fence_fd(struct vspm_if_fence_fd_t *fence_fd, int ok)
+{
+	if (!fence_fd->file)
+		return;
+
+	/* the fd is visible to user only after the result is copied */
+	if (ok) {
+		fd_install(fence_fd->fd, fence_fd->file);
+	} else {
+		put_unused_fd(fence_fd->fd);
+		fput(fence_fd->file);
+	}
+	fence_fd->file = NULL;
+}
+
+static int entry_one_fence(
+	struct vspm_if_private_t *priv,
+	struct vspm_if_fence_entry_t *req,
+	struct dma_fence **deps,
+	unsigned int dep_num,
+	struct dma_fence **out,
+	struct vspm_if_fence_fd_t *fence_fd)
+{
+	struct vspm_if_entry_v2_t entry;
+	struct vspm_if_tmpl_entry_t tmpl_entry;
+	struct vspm_if_in_fence_t *in_fence = NULL;
+	struct dma_fence *fence = NULL;
+	struct sync_file *sync_file = NULL;
+
+	unsigned int in_fence_num = 0;
+	int fd = -1;
+	int ercd;
+
+	fence_fd->file = NULL;
+
+	if (req->flags & ~(VSPM_IF_FENCE_OUT | VSPM_IF_FENCE_IN))
+		return -EINVAL;
+
+	/* get in-fences (and the fences of prerequisite jobs) */
+	if (req->flags & VSPM_IF_FENCE_IN) {
+		in_fence_num = req->in_fence_num;
+		if (in_fence_num == 0)
+			return -EINVAL;
+	}
+	if (in_fence_num || dep_num) {
+		in_fence = alloc_in_fence(
+			VSPM_IF_INT_TO_UP(req->in_fences), in_fence_num,
+			deps, dep_num);
+		if (IS_ERR(in_fence))
+			return PTR_ERR(in_fence);
+	}
+
+	/* prepare out-fence not to fail after the job is entried */
+	if ((req->flags & VSPM_IF_FENCE_OUT) || out) {
+		fence = alloc_out_fence();
+		if (!fence) {
+			ercd = -ENOMEM;
+			goto exit;
+		}
+	}
+
+	if (req->flags & VSPM_IF_FENCE_OUT) {
+		sync_file = sync_file_create(fence);
+		if (!sync_file) {
+			ercd = -ENOMEM;
+			goto exit;
+		}
+
+		fd = get_unused_fd_flags(O_CLOEXEC);
+		if (fd < 0) {
+			ercd = fd;
+			goto exit;
+		}
+	}
+
+	/* entry job */
+	switch (req->opcode) {
+	case VSPM_IF_SQE_ENTRY_V2:
+		entry.req = req->req.v2;
+		ercd = entry_one_v2(priv, &entry, fence, in_fence);
+		if (!ercd)
+			req->rsp = entry.rsp;
+		break;
+	case VSPM_IF_SQE_TMPL_ENTRY:
+		tmpl_entry.req = req->req.tmpl;
+		ercd = entry_one_tmpl(priv, &tmpl_entry, fence, in_fence);
+		if (!ercd)
+			req->rsp = tmpl_entry.rsp;
+		break;
+	default:
+		ercd = -EINVAL;
+		break;
+	}
+	if (ercd)
+		goto exit;
+
+	/* in-fences are owned by the job waiting for them */
+	if (req->rsp.ercd == R_VSPM_OK)
+		in_fence = NULL;
+
+	/* return out-fence of the entried job (installed by caller) */
+	req->out_fence = -1;
+	if (sync_file && req->rsp.ercd == R_VSPM_OK) {
+		fence_fd->fd = fd;
+		fence_fd->file = sync_file->file;
+		req->out_fence = fd;
+		sync_file = NULL;
+		fd = -1;
+	}
+
+	/* (canceled if the job was not entried) */
+	if (out)
+		*out = dma_fence_get(fence);
+
+exit:
+	if (in_fence)
+		free_in_fence(in_fence);
+	if (fd >= 0)
+		put_unused_fd(fd);
+	if (sync_file)
+		fput(sync_file->file);
+	dma_fence_put(fence);
+
+	return ercd;
+}
+
+static long vspm_ioctl_entry_fence(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_fence_entry_t req;
+	struct vspm_if_fence_fd_t fence_fd;
+	int ercd;
+
+	/* copy entry parameter */
+	if (copy_from_user(&req, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("FENCE: failed to copy the entry parameter\n");
+		return -EFAULT;
+	}
+
+	/* entry job */
+	ercd = entry_one_fence(priv, &req, NULL, 0, NULL, &fence_fd);
+	if (ercd)
+		return ercd;
+
+	/* copy result to user */
+	if (copy_to_user(
+			(void __user *)arg, &req, _IOC_SIZE(cmd))) {
+		APRINT("FENCE: failed to copy the result\n");
+		install_fence_fd(&fence_fd, 0);
+		return -EFAULT;
+	}
+	install_fence_fd(&fence_fd, 1);
+
+	return 0;
+}
+
+static long vspm_ioctl_entry_graph(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_entry_graph_t graph;
+	struct vspm_if_graph_node_t *node;
+	struct vspm_if_fence_fd_t *fence_fd;
+	struct dma_fence *fence[VSPM_IF_GRAPH_NODE_MAX] = { NULL };
+	struct dma_fence *deps[VSPM_IF_GRAPH_NODE_MAX];
+
+	unsigned int dep_num;
+	unsigned int i;
+	unsigned int j;
+	int copied = 1;
+	int ercd = 0;
+
+	/* copy graph parameter */
+	if (copy_from_user(&graph, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("GRAPH: failed to copy the graph parameter\n");
+		return -EFAULT;
+	}
+
+	if (graph.num == 0 || graph.num > VSPM_IF_GRAPH_NODE_MAX)
+		return -EINVAL;
+
+	node = kmalloc_array(
+		graph.num, sizeof(struct vspm_if_graph_node_t), GFP_KERNEL);
+	if (!node)
+		return -ENOMEM;
+
+	fence_fd = kmalloc_array(
+		graph.num, sizeof(struct vspm_if_fence_fd_t), GFP_KERNEL);
+	if (!fence_fd) {
+		kfree(node);
+		return -ENOMEM;
+	}
+
+	/* copy nodes at once */
+	if (copy_from_user(
+			node,
+			VSPM_IF_INT_TO_UP(graph.node),
+			graph.num * sizeof(struct vspm_if_graph_node_t))) {
+		EPRINT("GRAPH: failed to copy the node parameter\n");
+		kfree(fence_fd);
+		kfree(node);
+		return -EFAULT;
+	}
+
+	/* entry jobs in order until the first failure */
+	for (i = 0; i < graph.num; i++) {
+		/* only earlier nodes can be prerequisites */
+		if (node[i].deps >> i) {
+			ercd = -EINVAL;
+			break;
+		}
+
+		dep_num = 0;
+		for (j = 0; j < i; j++) {
+			if (node[i].deps & (1U << j))
+				deps[dep_num++] = fence[j];
+		}
+
+		/* the job is entried when all prerequisites are done */
+		ercd = entry_one_fence(
+			priv, &node[i].entry, deps, dep_num, &fence[i],
+			&fence_fd[i]);
+		if (ercd)
+			break;
+		if (node[i].entry.rsp.ercd != R_VSPM_OK) {
+			i++;
+			break;
+		}
+	}
+	graph.done = i;
+
+	/* copy results to user */
+	if (graph.done) {
+		if (copy_to_user(
+				VSPM_IF_INT_TO_UP(graph.node),
+				node,
+				graph.done *
+				sizeof(struct vspm_if_graph_node_t)))
+			copied = 0;
+	}
+	if (copy_to_user((void __user *)arg, &graph, _IOC_SIZE(cmd)))
+		copied = 0;
+	if (!copied) {
+		APRINT("GRAPH: failed to copy the result\n");
+		ercd = -EFAULT;
+	}
+
+	for (i = 0; i < graph.done; i++) {
+		install_fence_fd(&fence_fd[i], copied);
+		dma_fence_put(fence[i]);
+	}
+
+	kfree(fence_fd);
+	kfree(node);
+	return ercd;
+}
+
+static int sq_entry_v2(
+	struct vspm_if_private_t *priv, struct vspm_if_entry_v2_t *entry)
+{
+	struct vspm_if_sq_t *sq = priv->sq;
+	struct vspm_if_entry_v2_req_t *req = &entry->req;
+
+	if (req->job_size < sizeof(struct vspm_if_job_v2_t) ||
+	    req->job_size > VSPM_IF_JOB_V2_MAX_SIZE)
+		return -EINVAL;
+
+	if (req->job_param > sq->arena_size ||
+	    req->job_size > sq->arena_size - req->job_param)
+		return -EINVAL;
+
+	/* copy job descriptor not to be changed by user while marshalling */
+	memcpy(sq->desc, sq->arena + req->job_param, req->job_size);
+
+	return entry_job_v2(priv, entry, sq->desc, NULL, NULL);
+}
+
+static void sq_entry_one(
+	struct vspm_if_private_t *priv, const struct vspm_if_sqe_t *sqe)
+{
+	struct vspm_if_entry_v2_t entry;
+	struct vspm_if_tmpl_entry_t tmpl_entry;
+
+	unsigned long long user_data;
+	unsigned long long cb_func;
+	long long rsp_ercd = R_VSPM_OK;
+	int ercd;
+
+	switch (sqe->opcode) {
+	case VSPM_IF_SQE_ENTRY_V2:
+		entry.req = sqe->req.v2;
+		user_data = entry.req.user_data;
+		cb_func = entry.req.cb_func;
+		ercd = sq_entry_v2(priv, &entry);
+		if (!ercd)
+			rsp_ercd = entry.rsp.ercd;
+		break;
+	case VSPM_IF_SQE_TMPL_ENTRY:
+		tmpl_entry.req = sqe->req.tmpl;
+		user_data = tmpl_entry.req.user_data;
+		cb_func = tmpl_entry.req.cb_func;
+		ercd = entry_one_tmpl(priv, &tmpl_entry, NULL, NULL);
+		if (!ercd)
+			rsp_ercd = tmpl_entry.rsp.ercd;
+		break;
+	default:
+		/* reported with the user data at the position of v2 */
+		EPRINT("SQ: invalid opcode %u\n", sqe->opcode);
+		user_data = sqe->req.v2.user_data;
+		cb_func = sqe->req.v2.cb_func;
+		ercd = -EINVAL;
+		break;
+	}
+
+	/* report the job that could not be entried */
+	if (ercd == -ENOMEM)
+		sq_post_error(priv, user_data, cb_func, R_VSPM_NG);
+	else if (ercd)
+		sq_post_error(priv, user_data, cb_func, R_VSPM_PARAERR);
+	else if (rsp_ercd != R_VSPM_OK)
+		sq_post_error(priv, user_data, cb_func, (long)rsp_ercd);
+}
+
+static unsigned int sq_submit(struct vspm_if_private_t *priv)
+{
+	struct vspm_if_sq_t *sq = priv->sq;
+	struct vspm_if_sqe_t sqe;
+
+	unsigned int tail;
+	unsigned int count = 0;
+
+	mutex_lock(&sq->lock);
+
+	tail = smp_load_acquire(&sq->ring->tail);
+	if (tail - sq->head > sq->entries) {
+		/* invalid tail is written by user */
+		EPRINT("SQ: invalid tail %u (head %u)\n", tail, sq->head);
+		tail = sq->head + sq->entries;
+	}
+
+	while (sq->head != tail) {
+		/* reserve the record to report an error of the entry */
+		if (!sq->err_rec) {
+			sq->err_rec = get_entry_data(priv);
+			if (!sq->err_rec) {
+				/* leave the entry to be retried */
+				WRITE_ONCE(sq->ring->flags,
+					   sq->ring->flags | VSPM_IF_SQ_STALLED);
+				break;
+			}
+			WRITE_ONCE(sq->ring->flags,
+				   sq->ring->flags & ~VSPM_IF_SQ_STALLED);
+		}
+
+		/* copy entry and release the slot */
+		sqe = sq->sqes[sq->head & (sq->entries - 1)];
+		sq->head++;
+		smp_store_release(&sq->ring->head, sq->head);
+
+		/* entry job */
+		sq_entry_one(priv, &sqe);
+		count++;
+	}
+
+	mutex_unlock(&sq->lock);
+
+	return count;
+}
+
+static int sq_thread(void *data)
+{
+	struct vspm_if_private_t *priv = (struct vspm_if_private_t *)data;
+	struct vspm_if_sq_t *sq = priv->sq;
+	unsigned long timeout = jiffies + sq->idle_time;
+
+	while (!kthread_should_stop()) {
+		if (sq_submit(priv)) {
+			timeout = jiffies + sq->idle_time;
+			cond_resched();
+			continue;
+		}
+
+		/* retry the entries left for lack of memory later */
+		if (READ_ONCE(sq->ring->flags) & VSPM_IF_SQ_STALLED) {
+			schedule_timeout_interruptible(1);
+			continue;
+		}
+
+		/* keep polling until idle time is passed */
+		if (time_before(jiffies, timeout)) {
+			cond_resched();
+			continue;
+		}
+
+		/* sleep until VSPM_IOC_CMD_SQ_ENTER */
+		set_current_state(TASK_INTERRUPTIBLE);
+		WRITE_ONCE(sq->ring->flags,
+			   sq->ring->flags | VSPM_IF_SQ_NEED_WAKEUP);
+		smp_mb();
+		if (READ_ONCE(sq->ring->tail) == sq->head &&
+		    !kthread_should_stop())
+			schedule();
+		__set_current_state(TASK_RUNNING);
+		WRITE_ONCE(sq->ring->flags,
+			   sq->ring->flags & ~VSPM_IF_SQ_NEED_WAKEUP);
+
+		timeout = jiffies + sq->idle_time;
+	}
+
+	return 0;
+}
+
+static long vspm_ioctl_sq_setup(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_sq_setup_t setup;
+	struct vspm_if_sq_t *sq;
+
+	unsigned int sqe_off;
+	unsigned int arena_off;
+	long ercd;
+
+	/* copy setup parameter */
+	if (copy_from_user(&setup, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("SQ: failed to copy the setup parameter\n");
+		return -EFAULT;
+	}
+
+	if (setup.entries == 0 ||
+	    setup.entries > VSPM_IF_SQ_ENTRIES_MAX ||
+	    !is_power_of_2(setup.entries) ||
+	    setup.arena_size > VSPM_IF_SQ_ARENA_MAX)
+		return -EINVAL;
+
+	/* layout of the ring */
+	sqe_off = sizeof(struct vspm_if_sq_ring_t);
+	arena_off = sqe_off + setup.entries * sizeof(struct vspm_if_sqe_t);
+	arena_off = ALIGN(arena_off, 8);
+
+	/* allocate memory */
+	sq = kzalloc(sizeof(struct vspm_if_sq_t), GFP_KERNEL);
+	if (!sq)
+		return -ENOMEM;
+
+	mutex_init(&sq->lock);
+	sq->ring_size = PAGE_ALIGN(arena_off + setup.arena_size);
+	sq->entries = setup.entries;
+	sq->arena_size = setup.arena_size;
+	sq->idle_time = msecs_to_jiffies(
+		setup.idle_time ? setup.idle_time : 1000);
+
+	sq->desc = kmalloc(VSPM_IF_JOB_V2_MAX_SIZE, GFP_KERNEL);
+	sq->ring = vmalloc_user(sq->ring_size);
+	if (!sq->desc || !sq->ring) {
+		ercd = -ENOMEM;
+		goto err_exit;
+	}
+
+	sq->sqes = (struct vspm_if_sqe_t *)((char *)sq->ring + sqe_off);
+	sq->arena = (unsigned char *)sq->ring + arena_off;
+
+	sq->ring->mask = setup.entries - 1;
+	sq->ring->entries = setup.entries;
+	sq->ring->sqe_off = sqe_off;
+	sq->ring->arena_off = arena_off;
+	sq->ring->arena_size = setup.arena_size;
+
+	/* only one ring per handle */
+	mutex_lock(&priv->ring_lock);
+	if (priv->sq) {
+		mutex_unlock(&priv->ring_lock);
+		ercd = -EBUSY;
+		goto err_exit;
+	}
+
+	priv->sq = sq;
+
+	/* start polling thread */
+	if (setup.flags & VSPM_IF_SQ_SETUP_THREAD) {
+		sq->thread = kthread_run(sq_thread, priv, "vspm_if_sq");
+		if (IS_ERR(sq->thread)) {
+			ercd = PTR_ERR(sq->thread);
+			sq->thread = NULL;
+			priv->sq = NULL;
+			mutex_unlock(&priv->ring_lock);
+			goto err_exit;
+		}
+	}
+
+	/* copy result to user */
+	setup.ring_size = sq->ring_size;
+	if (copy_to_user((void __user *)arg, &setup, _IOC_SIZE(cmd))) {
+		EPRINT("SQ: failed to copy the result\n");
+		release_sq(priv);
+		mutex_unlock(&priv->ring_lock);
+		return -EFAULT;
+	}
+
+	mutex_unlock(&priv->ring_lock);
+	return 0;
+
+err_exit:
+	vfree(sq->ring);
+	kfree(sq->desc);
+	kfree(sq);
+	return ercd;
+}
+
+static long vspm_ioctl_sq_enter(struct vspm_if_private_t *priv)
+{
+	struct vspm_if_sq_t *sq = priv->sq;
+
+	if (!sq)
+		return -EINVAL;
+
+	/* wake up polling thread */
+	if (sq->thread) {
+		wake_up_process(sq->thread);
+		return 0;
+	}
+
+	/* return the number of consumed entries */
+	return (long)sq_submit(priv);
+}
+
+static long vspm_ioctl_cq_setup(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_cq_setup_t setup;
+	struct vspm_if_cq_t *cq;
+	unsigned long lock_flag;
+
+	unsigned int cqe_off;
+	long ercd;
+
+	/* copy setup parameter */
+	if (copy_from_user(&setup, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("CQ: failed to copy the setup parameter\n");
+		return -EFAULT;
+	}
+
+	if (setup.entries == 0 ||
+	    setup.entries > VSPM_IF_CQ_ENTRIES_MAX ||
+	    !is_power_of_2(setup.entries))
+		return -EINVAL;
+
+	/* layout of the ring */
+	cqe_off = sizeof(struct vspm_if_cq_ring_t);
+
+	/* allocate memory */
+	cq = kzalloc(sizeof(struct vspm_if_cq_t), GFP_KERNEL);
+	if (!cq)
+		return -ENOMEM;
+
+	init_waitqueue_head(&cq->wait);
+	cq->ring_size = PAGE_ALIGN(
+		cqe_off + setup.entries * sizeof(struct vspm_if_cqe_t));
+	cq->entries = setup.entries;
+
+	cq->ring = vmalloc_user(cq->ring_size);
+	if (!cq->ring) {
+		kfree(cq);
+		return -ENOMEM;
+	}
+
+	cq->cqes = (struct vspm_if_cqe_t *)((char *)cq->ring + cqe_off);
+
+	cq->ring->mask = setup.entries - 1;
+	cq->ring->entries = setup.entries;
+	cq->ring->cqe_off = cqe_off;
+
+	/* only one ring per handle */
+	mutex_lock(&priv->ring_lock);
+	if (priv->cq) {
+		ercd = -EBUSY;
+		goto err_exit;
+	}
+
+	/* copy result to user */
+	setup.ring_size = cq->ring_size;
+	if (copy_to_user((void __user *)arg, &setup, _IOC_SIZE(cmd))) {
+		EPRINT("CQ: failed to copy the result\n");
+		ercd = -EFAULT;
+		goto err_exit;
+	}
+
+	/* callbacks after here are written to the ring */
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	priv->cq = cq;
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+
+	mutex_unlock(&priv->ring_lock);
+	return 0;
+
+err_exit:
+	mutex_unlock(&priv->ring_lock);
+	vfree(cq->ring);
+	kfree(cq);
+	return ercd;
+}
+
+static int cq_ready(struct vspm_if_cq_t *cq)
+{
+	return READ_ONCE(cq->ring->head) != READ_ONCE(cq->tail);
+}
+
+static long vspm_ioctl_cq_wait(struct vspm_if_private_t *priv)
+{
+	struct vspm_if_cq_t *cq = priv->cq;
+
+	if (!cq)
+		return -EINVAL;
+
+	/* wait until the ring is not empty */
+	if (wait_event_interruptible(
+			cq->wait, cq_ready(cq) || READ_ONCE(cq->stop)))
+		return -EINTR;
+
+	/* stopped by VSPM_IOC_CMD_STOP_THREAD */
+	if (xchg(&cq->stop, 0))
+		return -ECANCELED;
+
+	return 0;
+}
+
+static long vspm_ioctl_set_config(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_config_t config;
+
+	/* copy configuration */
+	if (copy_from_user(&config, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("CONFIG: failed to copy the configuration\n");
+		return -EFAULT;
+	}
+
+	/* applied by VSPM_IOC_CMD_INIT */
+	if (priv->handle)
+		return -EBUSY;
+
+	if (config.entry_pool_depth > VSPM_IF_ENTRY_POOL_MAX)
+		return -EINVAL;
+
+	if (config.dl_size &&
+	    (config.dl_size < VSPM_IF_DL_SIZE_MIN ||
+	     config.dl_size > VSPM_IF_DL_SIZE_MAX ||
+	     config.dl_size & 7))
+		return -EINVAL;
+
+	priv->config = config;
+	return 0;
+}
+
+static long vspm_ioctl_get_stats(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_stats_t stats;
+	unsigned long lock_flag;
+
+	memset(&stats, 0, sizeof(struct vspm_if_stats_t));
+
+	/* entry data pool */
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	stats.entry_pool_depth = priv->entry_pool.depth;
+	stats.entry_pool_free = priv->entry_pool.free;
+	stats.entry_pool_miss = priv->entry_pool.miss;
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+
+	/* work buffer */
+	spin_lock_irqsave(&priv->work_pool.lock, lock_flag);
+	stats.work_buff_num = priv->work_pool.num;
+	stats.work_buff_used = priv->work_pool.used;
+	stats.work_buff_peak = priv->work_pool.peak;
+	stats.work_mem_used = priv->work_pool.mem_used;
+	stats.work_mem_peak = priv->work_pool.mem_peak;
+	spin_unlock_irqrestore(&priv->work_pool.lock, lock_flag);
+
+	/* cache of work memory (module-wide) */
+	get_work_mem_stats(&stats);
+
+	/* table cache */
+	mutex_lock(&priv->tbl_lock);
+	stats.table_num = priv->table_num;
+	mutex_unlock(&priv->tbl_lock);
+
+	/* dma-buf cache */
+	mutex_lock(&priv->dmabuf_lock);
+	stats.dmabuf_num = priv->dmabuf_num;
+	mutex_unlock(&priv->dmabuf_lock);
+
+	/* user pointer cache */
+	mutex_lock(&priv->uptr_lock);
+	stats.userptr_num = priv->uptr_num;
+	stats.userptr_miss = priv->uptr_miss;
+	mutex_unlock(&priv->uptr_lock);
+
+	/* copy statistics to user */
+	if (copy_to_user((void __user *)arg, &stats, _IOC_SIZE(cmd))) {
+		EPRINT("STATS: failed to copy the statistics\n");
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
+static long vspm_ioctl_tbl_register(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_tbl_reg_t reg;
+	struct vspm_if_tbl_t *tbl;
+	struct vspm_if_tbl_t *old = NULL;
+
+	int ercd;
+
+	/* copy register parameter */
+	if (copy_from_user(&reg, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("TBL: failed to copy the register parameter\n");
+		return -EFAULT;
+	}
+
+	if (reg.tbl_num == 0 || reg.tbl_num > VSPM_IF_TBL_NUM_MAX ||
+	    reg.id > INT_MAX)
+		return -EINVAL;
+
+	/* copy table to DMA memory */
+	tbl = alloc_tbl(VSPM_IF_INT_TO_UP(reg.tbl_addr), reg.tbl_num);
+	if (IS_ERR(tbl))
+		return PTR_ERR(tbl);
+
+	/* register table */
+	mutex_lock(&priv->tbl_lock);
+	if (reg.id == 0) {
+		ercd = idr_alloc(&priv->tbl_idr, tbl, 1, 0, GFP_KERNEL);
+	} else {
+		old = idr_replace(&priv->tbl_idr, tbl, reg.id);
+		if (IS_ERR(old)) {
+			old = NULL;
+			ercd = idr_alloc(
+				&priv->tbl_idr,
+				tbl,
+				reg.id,
+				reg.id + 1,
+				GFP_KERNEL);
+		} else {
+			ercd = reg.id;
+		}
+	}
+	if (ercd < 0) {
+		mutex_unlock(&priv->tbl_lock);
+		put_tbl(tbl);
+		return ercd;
+	}
+
+	reg.id = (unsigned int)ercd;
+
+	/* copy result to user (under the lock to restore the id) */
+	if (copy_to_user((void __user *)arg, &reg, _IOC_SIZE(cmd))) {
+		EPRINT("TBL: failed to copy the result\n");
+		if (old)
+			(void)idr_replace(&priv->tbl_idr, old, reg.id);
+		else
+			idr_remove(&priv->tbl_idr, reg.id);
+		mutex_unlock(&priv->tbl_lock);
+		put_tbl(tbl);
+		return -EFAULT;
+	}
+
+	if (!old)
+		priv->table_num++;
+	mutex_unlock(&priv->tbl_lock);
+
+	/* the previous table is released after the last job using it */
+	put_tbl(old);
+
+	return 0;
+}
+
+static long vspm_ioctl_tbl_unregister(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_tbl_t *tbl;
+	unsigned int id;
+
+	/* copy table id */
+	if (copy_from_user(&id, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("TBL: failed to copy the table id\n");
+		return -EFAULT;
+	}
+
+	/* unregister table */
+	mutex_lock(&priv->tbl_lock);
+	tbl = idr_remove(&priv->tbl_idr, id);
+	if (tbl)
+		priv->table_num--;
+	mutex_unlock(&priv->tbl_lock);
+	if (!tbl)
+		return -ENOENT;
+
+	/* the table is released after the last job using it */
+	put_tbl(tbl);
+
+	return 0;
+}
+
+static long vspm_ioctl_dmabuf_import(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_dmabuf_import_t import;
+	struct vspm_if_dmabuf_t *buf;
+	struct dma_buf *dmabuf;
+
+	int ercd = 0;
+	int id;
+
+	/* copy import parameter */
+	if (copy_from_user(&import, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("DMABUF: failed to copy the import parameter\n");
+		return -EFAULT;
+	}
+
+	dmabuf = dma_buf_get(import.fd);
+	if (IS_ERR(dmabuf))
+		return PTR_ERR(dmabuf);
+
+	mutex_lock(&priv->dmabuf_lock);
+
+	/* find the dma-buf already imported */
+	idr_for_each_entry(&priv->dmabuf_idr, buf, id) {
+		if (buf->dmabuf == dmabuf) {
+			buf->ref++;
+			goto set_result;
+		}
+	}
+
+	if (priv->dmabuf_num >= VSPM_IF_DMABUF_MAX) {
+		ercd = -ENOSPC;
+		goto err_exit;
+	}
+
+	/* attach and map */
+	buf = import_dmabuf(dmabuf);
+	if (IS_ERR(buf)) {
+		ercd = PTR_ERR(buf);
+		goto err_exit;
+	}
+
+	id = idr_alloc(&priv->dmabuf_idr, buf, 1, 0, GFP_KERNEL);
+	if (id < 0) {
+		release_dmabuf(buf);
+		ercd = id;
+		goto err_exit;
+	}
+	priv->dmabuf_num++;
+
+set_result:
+	import.id = (unsigned int)id;
+	import.addr = VSPM_IF_DMA_TO_INT(buf->addr);
+	import.size = (unsigned int)dmabuf->size;
+
+err_exit:
+	mutex_unlock(&priv->dmabuf_lock);
+	dma_buf_put(dmabuf);
+	if (ercd)
+		return ercd;
+
+	/* copy result to user */
+	if (copy_to_user((void __user *)arg, &import, _IOC_SIZE(cmd))) {
+		EPRINT("DMABUF: failed to copy the result\n");
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
+static long vspm_ioctl_dmabuf_release(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_dmabuf_t *buf;
+	unsigned int id;
+	long ercd = 0;
+
+	/* copy dma-buf id */
+	if (copy_from_user(&id, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("DMABUF: failed to copy the dma-buf id\n");
+		return -EFAULT;
+	}
+
+	mutex_lock(&priv->dmabuf_lock);
+	buf = idr_find(&priv->dmabuf_idr, id);
+	if (!buf) {
+		ercd = -ENOENT;
+	} else if (--buf->ref == 0) {
+		idr_remove(&priv->dmabuf_idr, id);
+		priv->dmabuf_num--;
+
+		/* jobs hold only the address, released after them */
+		if (retire_after_jobs(priv, &buf->seq, 0)) {
+			list_add_tail(&buf->list, &priv->dmabuf_retire);
+			schedule_work(&priv->retire_work);
+		} else {
+			release_dmabuf(buf);
+		}
+	}
+	mutex_unlock(&priv->dmabuf_lock);
+
+	return ercd;
+}
+
+static long vspm_ioctl_buf_register(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_buf_reg_t reg;
+	struct vspm_if_buf_table_t *table;
+
+	/* copy register parameter */
+	if (copy_from_user(&reg, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("BUF: failed to copy the register parameter\n");
+		return -EFAULT;
+	}
+
+	if (reg.num == 0 || reg.num > VSPM_IF_DMABUF_MAX)
+		return -EINVAL;
+
+	mutex_lock(&priv->dmabuf_lock);
+	if (priv->buf_table) {
+		mutex_unlock(&priv->dmabuf_lock);
+		return -EBUSY;
+	}
+
+	/* attach and map all buffers */
+	table = alloc_buf_table(
+		(const int __user *)VSPM_IF_INT_TO_UP(reg.fds), reg.num);
+	if (!IS_ERR(table))
+		priv->buf_table = table;
+	mutex_unlock(&priv->dmabuf_lock);
+
+	return IS_ERR(table) ? PTR_ERR(table) : 0;
+}
+
+static long vspm_ioctl_buf_unregister(struct vspm_if_private_t *priv)
+{
+	struct vspm_if_buf_table_t *table;
+
+	mutex_lock(&priv->dmabuf_lock);
+	table = priv->buf_table;
+	priv->buf_table = NULL;
+	mutex_unlock(&priv->dmabuf_lock);
+	if (!table)
+		return -ENOENT;
+
+	/* the buffers are released after the last job using them */
+	put_buf_table(table);
+
+	return 0;
+}
+
+static long vspm_ioctl_buf_alloc(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_buf_alloc_t alloc;
+	struct vspm_if_dmabuf_t *buf;
+	struct dma_buf *dmabuf;
+
+	unsigned long long offset[3];
+	unsigned long long size;
+	int ercd;
+	int id;
+
+	/* copy allocation parameter */
+	if (copy_from_user(&alloc, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("BUF: failed to copy the allocation parameter\n");
+		return -EFAULT;
+	}
+
+	if (alloc.width == 0 || alloc.height == 0 ||
+	    alloc.stride < alloc.width ||
+	    alloc.planes == 0 || alloc.planes > 3)
+		return -EINVAL;
+	if (alloc.planes > 1 && (alloc.height_c == 0 || alloc.stride_c == 0))
+		return -EINVAL;
+
+	/* layout of planes */
+	offset[0] = 0;
+	size = (unsigned long long)alloc.stride * alloc.height;
+	offset[1] = ALIGN(size, VSPM_IF_MEM_ALIGN);
+	if (alloc.planes > 1)
+		size = offset[1] +
+			(unsigned long long)alloc.stride_c * alloc.height_c;
+	offset[2] = ALIGN(size, VSPM_IF_MEM_ALIGN);
+	if (alloc.planes > 2)
+		size = offset[2] +
+			(unsigned long long)alloc.stride_c * alloc.height_c;
+	size = PAGE_ALIGN(size);
+	if (size > VSPM_IF_BUF_SIZE_MAX)
+		return -EINVAL;
+
+	/* allocate and export */
+	dmabuf = alloc_export_buf((size_t)size);
+	if (IS_ERR(dmabuf))
+		return PTR_ERR(dmabuf);
+
+	/* import to this file descriptor */
+	mutex_lock(&priv->dmabuf_lock);
+	if (priv->dmabuf_num >= VSPM_IF_DMABUF_MAX) {
+		ercd = -ENOSPC;
+		goto err_exit;
+	}
+
+	buf = import_dmabuf(dmabuf);
+	if (IS_ERR(buf)) {
+		ercd = PTR_ERR(buf);
+		goto err_exit;
+	}
+
+	id = idr_alloc(&priv->dmabuf_idr, buf, 1, 0, GFP_KERNEL);
+	if (id < 0) {
+		release_dmabuf(buf);
+		ercd = id;
+		goto err_exit;
+	}
+	priv->dmabuf_num++;
+	mutex_unlock(&priv->dmabuf_lock);
+
+	/* reserve the fd, it is installed after the result is copied */
+	alloc.fd = get_unused_fd_flags(O_CLOEXEC);
+	if (alloc.fd < 0) {
+		ercd = alloc.fd;
+		goto err_exit2;
+	}
+
+	alloc.id = (unsigned int)id;
+	alloc.addr = VSPM_IF_DMA_TO_INT(buf->addr + offset[0]);
+	alloc.addr_c0 = alloc.planes > 1 ?
+		VSPM_IF_DMA_TO_INT(buf->addr + offset[1]) : 0;
+	alloc.addr_c1 = alloc.planes > 2 ?
+		VSPM_IF_DMA_TO_INT(buf->addr + offset[2]) : 0;
+	alloc.size = (unsigned int)size;
+
+	/* copy result to user */
+	if (copy_to_user((void __user *)arg, &alloc, _IOC_SIZE(cmd))) {
+		EPRINT("BUF: failed to copy the result\n");
+		put_unused_fd(alloc.fd);
+		ercd = -EFAULT;
+		goto err_exit2;
+	}
+
+	/* the file descriptor owns the reference of export */
+	fd_install(alloc.fd, dmabuf->file);
+
+	return 0;
+
+err_exit2:
+	mutex_lock(&priv->dmabuf_lock);
+	idr_remove(&priv->dmabuf_idr, id);
+	priv->dmabuf_num--;
+	release_dmabuf(buf);
+err_exit:
+	mutex_unlock(&priv->dmabuf_lock);
+	dma_buf_put(dmabuf);
+	return ercd;
+}
+
+static struct vspm_if_uptr_t *find_uptr(
+	struct vspm_if_private_t *priv, const struct vspm_if_userptr_t *req)
+{
+	struct vspm_if_uptr_t *uptr;
+
+	list_for_each_entry(uptr, &priv->uptr_lru, list) {
+		if (uptr->mm == current->mm &&
+		    uptr->user_addr == req->user_addr &&
+		    uptr->size == req->size)
+			return uptr;
+	}
+
+	return NULL;
+}
+
+static long vspm_ioctl_userptr_map(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_userptr_t req;
+	struct vspm_if_uptr_t *uptr;
+	struct vspm_if_uptr_t *lru;
+
+	/* copy map parameter */
+	if (copy_from_user(&req, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("USERPTR: failed to copy the map parameter\n");
+		return -EFAULT;
+	}
+
+	if (req.size == 0 || req.user_addr > ULONG_MAX - req.size)
+		return -EINVAL;
+
+	mutex_lock(&priv->uptr_lock);
+
+	uptr = find_uptr(priv, &req);
+	if (uptr) {
+		/* the pages are already pinned and mapped */
+		dma_sync_sg_for_device(
+			&g_vspmif_pdev->dev,
+			uptr->sgt.sgl,
+			uptr->sgt.orig_nents,
+			DMA_BIDIRECTIONAL);
+	} else {
+		/* evict the least recently used mapping if full */
+		if (priv->uptr_num >= VSPM_IF_USERPTR_CACHE_MAX) {
+			lru = NULL;
+			list_for_each_entry_reverse(
+				uptr, &priv->uptr_lru, list) {
+				if (!uptr->ref) {
+					lru = uptr;
+					break;
+				}
+			}
+			if (!lru) {
+				mutex_unlock(&priv->uptr_lock);
+				return -ENOSPC;
+			}
+			list_del(&lru->list);
+			priv->uptr_num--;
+
+			/* jobs before its unmap may be still using it */
+			if (lru->pending)
+				list_add_tail(&lru->list, &priv->uptr_retire);
+			else
+				release_uptr(lru);
+		}
+
+		/* pin and map (also flushes CPU cache to the device) */
+		uptr = alloc_uptr((unsigned long)req.user_addr, req.size);
+		if (IS_ERR(uptr)) {
+			mutex_unlock(&priv->uptr_lock);
+			return PTR_ERR(uptr);
+		}
+		list_add(&uptr->list, &priv->uptr_lru);
+		priv->uptr_num++;
+		priv->uptr_miss++;
+	}
+
+	/* most recently used first */
+	list_move(&uptr->list, &priv->uptr_lru);
+	uptr->ref++;
+	req.addr = VSPM_IF_DMA_TO_INT(uptr->addr);
+
+	mutex_unlock(&priv->uptr_lock);
+
+	/* copy result to user */
+	if (copy_to_user((void __user *)arg, &req, _IOC_SIZE(cmd))) {
+		EPRINT("USERPTR: failed to copy the result\n");
+		return -EFAULT;
+	}
+
+	return 0;
+}
+
+static long vspm_ioctl_userptr_unmap(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_userptr_t req;
+	struct vspm_if_uptr_t *uptr;
+
+	int evict;
+
+	/* copy unmap parameter */
+	if (copy_from_user(&req, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("USERPTR: failed to copy the unmap parameter\n");
+		return -EFAULT;
+	}
+
+	mutex_lock(&priv->uptr_lock);
+
+	uptr = find_uptr(priv, &req);
+	if (!uptr || !uptr->ref) {
+		mutex_unlock(&priv->uptr_lock);
+		return -ENOENT;
+	}
 
-		/* release memory */
-		kfree(priv);
+	/* keep the mapping in cache unless evicted */
+	evict = --uptr->ref == 0 && (req.flags & VSPM_IF_USERPTR_EVICT);
+	if (evict) {
+		list_del(&uptr->list);
+		priv->uptr_num--;
 	}
 
-	file->private_data = NULL;
+	/* jobs hold only the address, the device may be still using it */
+	if (retire_after_jobs(priv, &uptr->seq, uptr->pending)) {
+		/* sync (and unpin) after the jobs entried so far */
+		uptr->pending = 1;
+		if (evict)
+			list_add_tail(&uptr->list, &priv->uptr_retire);
+		schedule_work(&priv->retire_work);
+	} else {
+		/* make the result of device visible to CPU */
+		uptr->pending = 0;
+		dma_sync_sg_for_cpu(
+			&g_vspmif_pdev->dev,
+			uptr->sgt.sgl,
+			uptr->sgt.orig_nents,
+			DMA_BIDIRECTIONAL);
+		if (evict)
+			release_uptr(uptr);
+	}
+
+	mutex_unlock(&priv->uptr_lock);
+
 	return 0;
 }
 
-static long vspm_ioctl_init(
+static long vspm_ioctl_pipe_init(
 	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
 {
+	struct vspm_if_pipe_init_t pipe;
 	struct vspm_init_t init_par;
-	struct vspm_init_fdp_t init_fdp_par;
 
 	void *handle;
 	long ercd;
 
 	/* copy initialize parameter */
-	if (copy_from_user(
-			&init_par, (void __user *)arg, _IOC_SIZE(cmd))) {
-		EPRINT("INIT: failed to copy from user!!\n");
+	if (copy_from_user(&pipe, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("PIPE: failed to copy the initialize parameter\n");
 		return -EFAULT;
 	}
 
-	switch (init_par.type) {
-	case VSPM_TYPE_VSP_AUTO:
-		/* initialize parameter is not used */
-		init_par.par.vsp = NULL;
-		break;
-	case VSPM_TYPE_FDP_AUTO:
-		/* copy initialize parameter of FDP */
-		if (init_par.par.fdp) {
-			if (copy_from_user(
-					&init_fdp_par,
-					(void __user *)init_par.par.fdp,
-					sizeof(struct vspm_init_fdp_t))) {
-				EPRINT("INIT: failed to copy FDP param\n");
-				return -EFAULT;
-			}
-			init_par.par.fdp = &init_fdp_par;
-		}
-		break;
-	default:
-		break;
-	}
+	/* the fd is initialized for FDP first */
+	if (!priv->handle || priv->type != VSPM_TYPE_FDP_AUTO)
+		return -EINVAL;
+	if (priv->pipe_handle)
+		return -EBUSY;
 
-	/* initialize VSP manager */
+	memset(&init_par, 0, sizeof(struct vspm_init_t));
+	init_par.use_ch = pipe.use_ch;
+	init_par.mode = pipe.mode;
+	init_par.type = VSPM_TYPE_VSP_AUTO;
+	init_par.par.vsp = NULL;
+
+	/* initialize VSP manager for the VSP stage */
 	ercd = vspm_init_driver(&handle, &init_par);
 	switch (ercd) {
 	case R_VSPM_OK:
@@ -171,181 +2489,117 @@ static long vspm_ioctl_init(
 		return -EFAULT;
 	}
 
-	priv->handle = handle;
-	return 0;
-}
-
-static long vspm_ioctl_quit(struct vspm_if_private_t *priv)
-{
-	long ercd;
-
-	/* finalize VSP manager */
-	ercd = vspm_quit_driver(priv->handle);
-	if (ercd != R_VSPM_OK)
-		return -EFAULT;
-
-	priv->handle = NULL;
-
-	/* release entry data */
-	release_all_entry_data(priv);
-
+	priv->pipe_handle = handle;
 	return 0;
 }
 
-static void vspm_cb_func(
-	unsigned long job_id, long result, void *user_data)
+static int set_pipe_src(
+	struct vspm_if_private_t *priv,
+	const struct vspm_if_tmpl_entry_req_t *fdp,
+	struct vspm_if_tmpl_entry_req_t *vsp,
+	unsigned int src)
 {
-	struct vspm_if_entry_data_t *entry_data =
-		(struct vspm_if_entry_data_t *)user_data;
-
-	struct vspm_if_private_t *priv;
-	struct vspm_if_cb_data_t *cb_data;
-	unsigned long lock_flag;
-
-	if (!entry_data)
-		return;
-
-	priv = entry_data->priv;
+	const unsigned int fixed = VSPM_IF_TMPL_PATCH_FIXED_BUF;
+	const struct vspm_entry_fdp *tmpl_fdp;
+	struct vspm_if_tmpl_t *tmpl;
 
-	/* del list */
-	spin_lock_irqsave(&priv->lock, lock_flag);
-	list_del(&entry_data->list);
-	spin_unlock_irqrestore(&priv->lock, lock_flag);
-
-	/* allocate callback data */
-	cb_data = kzalloc(sizeof(struct vspm_if_cb_data_t), GFP_ATOMIC);
-	if (!cb_data) {
-		EPRINT("CB: failed to allocate memory\n");
-		/* release memory */
-		if (entry_data->job.type == VSPM_TYPE_VSP_AUTO)
-			free_vsp_par(&entry_data->ip_par.vsp);
-		kfree(entry_data);
-		return;
-	}
+	int ercd = -EINVAL;
 
-	/* make response data */
-	cb_data->rsp.ercd = 0;
-	cb_data->rsp.cb_func = entry_data->entry.req.cb_func;
-	cb_data->rsp.job_id = job_id;
-	cb_data->rsp.result = result;
-	cb_data->rsp.user_data = entry_data->entry.req.user_data;
+	if (src >= 5)
+		return -EINVAL;
 
-	if (entry_data->job.type == VSPM_TYPE_VSP_AUTO) {
-		/* set callback response of vsp */
-		set_cb_rsp_vsp(cb_data, entry_data);
+	if (fdp->patch & VSPM_IF_TMPL_PATCH_FDP_OUT) {
+		/* both are addresses, or offsets in the fixed buffers */
+		if ((fdp->patch & fixed) != (vsp->patch & fixed))
+			return -EINVAL;
+		vsp->src[src] = fdp->fdp_out;
+		vsp->buf_index[src] = fdp->buf_index[0];
+	} else {
+		if (vsp->patch & fixed)
+			return -EINVAL;
+
+		/* output buffer registered in the template of FDP */
+		mutex_lock(&priv->tmpl_lock);
+		tmpl = idr_find(&priv->tmpl_idr, fdp->id);
+		if (tmpl && tmpl->entry_data.job.type == VSPM_TYPE_FDP_AUTO) {
+			tmpl_fdp = &tmpl->entry_data.ip_par.fdp;
+			if (tmpl_fdp->par.fproc_par &&
+			    tmpl_fdp->fproc.fproc.out_buf) {
+				vsp->src[src].addr =
+					tmpl_fdp->fproc.out_buf.addr;
+				vsp->src[src].addr_c0 =
+					tmpl_fdp->fproc.out_buf.addr_c0;
+				vsp->src[src].addr_c1 =
+					tmpl_fdp->fproc.out_buf.addr_c1;
+				ercd = 0;
+			}
+		}
+		mutex_unlock(&priv->tmpl_lock);
+		if (ercd)
+			return ercd;
 	}
 
-	/* addition list */
-	spin_lock_irqsave(&priv->lock, lock_flag);
-	list_add_tail(&cb_data->list, &priv->cb_data.list);
-	spin_unlock_irqrestore(&priv->lock, lock_flag);
-
-	complete(&priv->wait_interrupt);
-	kfree(entry_data);
+	vsp->patch |= VSPM_IF_TMPL_PATCH_SRC(src);
+	return 0;
 }
 
-static long vspm_ioctl_entry(
+static long vspm_ioctl_entry_pipe(
 	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
 {
-	struct vspm_if_entry_data_t *entry_data;
-	struct vspm_if_entry_req_t *entry_req;
-	struct vspm_if_entry_t entry;
-
-	unsigned long lock_flag;
-	int ercd = 0;
+	struct vspm_if_pipe_entry_t pipe;
+	struct vspm_if_fence_fd_t fence_fd[2];
+	struct dma_fence *fence = NULL;
 
-	/* allocate entry data */
-	entry_data = kzalloc(sizeof(struct vspm_if_entry_data_t), GFP_KERNEL);
-	if (!entry_data)
-		return -ENOMEM;
-	entry_data->priv = priv;
-
-	/* add list */
-	spin_lock_irqsave(&priv->lock, lock_flag);
-	list_add_tail(&entry_data->list, &priv->entry_data.list);
-	spin_unlock_irqrestore(&priv->lock, lock_flag);
+	int copied = 1;
+	int ercd;
 
 	/* copy entry parameter */
-	if (copy_from_user(
-			&entry_data->entry,
-			(void __user *)arg,
-			_IOC_SIZE(cmd))) {
-		EPRINT("ENTRY: failed to copy the entry parameter\n");
-		ercd = -EFAULT;
-		goto err_exit;
+	if (copy_from_user(&pipe, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("PIPE: failed to copy the entry parameter\n");
+		return -EFAULT;
 	}
 
-	entry_req = &entry_data->entry.req;
+	if (!priv->pipe_handle)
+		return -EINVAL;
 
-	if (entry_req->job_param) {
-		/* copy job parameter */
-		if (copy_from_user(
-				&entry_data->job,
-				(void __user *)entry_req->job_param,
-				sizeof(struct vspm_job_t))) {
-			EPRINT("ENTRY: failed to copy the job parameter\n");
-			ercd = -EFAULT;
-			goto err_exit;
-		}
-		entry_req->job_param = &entry_data->job;
-
-		switch (entry_data->job.type) {
-		case VSPM_TYPE_VSP_AUTO:
-			if (entry_data->job.par.vsp) {
-				/* copy start parameter of VSP */
-				ercd = set_vsp_par(
-					entry_data, entry_data->job.par.vsp);
-				if (ercd)
-					goto err_exit;
-
-				entry_req->job_param->par.vsp =
-					&entry_data->ip_par.vsp.par;
-			}
-			break;
-		case VSPM_TYPE_FDP_AUTO:
-			if (entry_data->job.par.fdp) {
-				/* copy start parameter of FDP */
-				ercd = set_fdp_par(
-					entry_data, entry_data->job.par.fdp);
-				if (ercd)
-					goto err_exit;
-
-				entry_req->job_param->par.fdp =
-					&entry_data->ip_par.fdp.par;
-			}
-			break;
-		default:
-			break;
-		}
-	}
+	if (pipe.fdp.opcode != VSPM_IF_SQE_TMPL_ENTRY ||
+	    pipe.vsp.opcode != VSPM_IF_SQE_TMPL_ENTRY)
+		return -EINVAL;
 
-	/* entry job */
-	entry.rsp.ercd = vspm_entry_job(
-		priv->handle,
-		&entry.rsp.job_id,
-		entry_req->priority,
-		entry_req->job_param,
-		(void *)entry_data,
-		vspm_cb_func);
+	/* feed the output buffer of FDP to VSP */
+	ercd = set_pipe_src(
+		priv, &pipe.fdp.req.tmpl, &pipe.vsp.req.tmpl, pipe.src);
+	if (ercd)
+		return ercd;
+
+	pipe.done = 0;
+
+	/* entry FDP stage */
+	ercd = entry_one_fence(
+		priv, &pipe.fdp, NULL, 0, &fence, &fence_fd[0]);
+	if (ercd)
+		return ercd;
+	pipe.done++;
+
+	/* entry VSP stage when FDP stage is done */
+	fence_fd[1].file = NULL;
+	if (pipe.fdp.rsp.ercd == R_VSPM_OK) {
+		ercd = entry_one_fence(
+			priv, &pipe.vsp, &fence, 1, NULL, &fence_fd[1]);
+		if (!ercd)
+			pipe.done++;
+	}
+	dma_fence_put(fence);
 
 	/* copy result to user */
 	if (copy_to_user(
-			(void __user *)arg, &entry, _IOC_SIZE(cmd)))
-		APRINT("ENTRY: failed to copy the result\n");
-
-	if (entry.rsp.ercd != R_VSPM_OK)
-		goto err_exit;
-
-	return 0;
-
-err_exit:
-	spin_lock_irqsave(&priv->lock, lock_flag);
-	list_del(&entry_data->list);
-	spin_unlock_irqrestore(&priv->lock, lock_flag);
-
-	if (entry_data->job.type == VSPM_TYPE_VSP_AUTO)
-		free_vsp_par(&entry_data->ip_par.vsp);
-	kfree(entry_data);
+			(void __user *)arg, &pipe, _IOC_SIZE(cmd))) {
+		APRINT("PIPE: failed to copy the result\n");
+		copied = 0;
+		ercd = -EFAULT;
+	}
+	install_fence_fd(&fence_fd[0], copied);
+	install_fence_fd(&fence_fd[1], copied);
 
 	return ercd;
 }
@@ -364,6 +2618,8 @@ static long vspm_ioctl_cancel(
 
 	/* cancel job */
 	ercd = vspm_cancel_job(priv->handle, job_id);
+	if (ercd == VSPM_STATUS_NO_ENTRY && priv->pipe_handle)
+		ercd = vspm_cancel_job(priv->pipe_handle, job_id);
 	switch (ercd) {
 	case R_VSPM_OK:
 		break;
@@ -418,6 +2674,61 @@ static long vspm_ioctl_get_status(
 	return 0;
 }
 
+static void copy_cb_vsp_result(struct vspm_if_cb_data_t *cb_data)
+{
+	/* HGO result */
+	if (cb_data->vsp_hgo.virt_addr) {
+		unsigned long tmp_addr =
+			(unsigned long)(cb_data->vsp_hgo.virt_addr);
+		tmp_addr = (tmp_addr + 255) >> 8;
+		/* copy to user area */
+		if (cb_data->vsp_hgo.user_addr) {
+			if (copy_to_user((void __user *)
+					cb_data->vsp_hgo.user_addr,
+					(void *)(tmp_addr << 8),
+					1088)) {
+				APRINT("CB: failed to copy HGO data\n");
+			}
+		}
+	}
+
+	/* HGT result */
+	if (cb_data->vsp_hgt.virt_addr) {
+		unsigned long tmp_addr =
+			(unsigned long)(cb_data->vsp_hgt.virt_addr);
+		tmp_addr = (tmp_addr + 255) >> 8;
+		/* copy to user area */
+		if (cb_data->vsp_hgt.user_addr) {
+			if (copy_to_user((void __user *)
+					cb_data->vsp_hgt.user_addr,
+					(void *)(tmp_addr << 8),
+					800)) {
+				APRINT("CB: failed to copy HGT data\n");
+			}
+		}
+	}
+}
+
+static unsigned int take_cb_data(
+	struct vspm_if_private_t *priv, struct list_head *list, unsigned int num)
+{
+	unsigned long lock_flag;
+	unsigned int i;
+
+	/* the completion of the first one is already waited by caller */
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	for (i = 0; i < num; i++) {
+		if (list_empty(&priv->cb_data.list))
+			break;
+		if (i && !try_wait_for_completion(&priv->wait_interrupt))
+			break;
+		list_move_tail(priv->cb_data.list.next, list);
+	}
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+
+	return i;
+}
+
 static long vspm_ioctl_wait_interrupt(
 	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
 {
@@ -454,37 +2765,8 @@ static long vspm_ioctl_wait_interrupt(
 		list_del(&cb_data->list);
 		spin_unlock_irqrestore(&priv->lock, lock_flag);
 
-		/* HGO result */
-		if (cb_data->vsp_hgo.virt_addr) {
-			unsigned long tmp_addr =
-				(unsigned long)(cb_data->vsp_hgo.virt_addr);
-			tmp_addr = (tmp_addr + 255) >> 8;
-			/* copy to user area */
-			if (cb_data->vsp_hgo.user_addr) {
-				if (copy_to_user((void __user *)
-						cb_data->vsp_hgo.user_addr,
-						(void *)(tmp_addr << 8),
-						1088)) {
-					APRINT("CB: failed to copy HGO data\n");
-				}
-			}
-		}
-
-		/* HGT result */
-		if (cb_data->vsp_hgt.virt_addr) {
-			unsigned long tmp_addr =
-				(unsigned long)(cb_data->vsp_hgt.virt_addr);
-			tmp_addr = (tmp_addr + 255) >> 8;
-			/* copy to user area */
-			if (cb_data->vsp_hgt.user_addr) {
-				if (copy_to_user((void __user *)
-						cb_data->vsp_hgt.user_addr,
-						(void *)(tmp_addr << 8),
-						800)) {
-					APRINT("CB: failed to copy HGT data\n");
-				}
-			}
-		}
+		/* copy histogram results */
+		copy_cb_vsp_result(cb_data);
 
 		/* copy response data to user */
 		if (copy_to_user(
@@ -496,10 +2778,82 @@ static long vspm_ioctl_wait_interrupt(
 		}
 
 		/* release memory */
-		free_cb_vsp_par(cb_data);
-		kfree(cb_data);
+		free_cb_data(cb_data);
+	}
+
+	return ercd;
+}
+
+static long vspm_ioctl_wait_interrupt_multi(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	struct vspm_if_cb_multi_t multi;
+	struct vspm_if_cb_rsp_t *rsp;
+	struct vspm_if_cb_data_t *cb_data;
+	struct vspm_if_cb_data_t *next;
+	LIST_HEAD(list);
+
+	unsigned int i = 0;
+	long ercd = 0;
+
+	/* copy multi parameter */
+	if (copy_from_user(&multi, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("CB_MULTI: failed to copy the multi parameter\n");
+		return -EFAULT;
+	}
+
+	if (multi.num == 0 || multi.num > VSPM_IF_CB_MULTI_MAX)
+		return -EINVAL;
+
+	rsp = kmalloc_array(
+		multi.num, sizeof(struct vspm_if_cb_rsp_t), GFP_KERNEL);
+	if (!rsp)
+		return -ENOMEM;
+
+	/* get user process information */
+	priv->thread = current;
+	complete(&priv->wait_thread);
+
+	/* wait process end */
+	if (wait_for_completion_interruptible(&priv->wait_interrupt)) {
+		kfree(rsp);
+		return -EINTR;
+	}
+
+	/* get response data at once */
+	multi.done = take_cb_data(priv, &list, multi.num);
+	if (!multi.done) {
+		/* set response data (ercd = -1) */
+		memset(&rsp[0], 0, sizeof(struct vspm_if_cb_rsp_t));
+		rsp[0].ercd = -1;
+		multi.done = 1;
+	}
+
+	list_for_each_entry_safe(cb_data, next, &list, list) {
+		/* copy histogram results */
+		copy_cb_vsp_result(cb_data);
+
+		rsp[i++] = cb_data->rsp;
+
+		/* release memory */
+		list_del(&cb_data->list);
+		free_cb_data(cb_data);
+	}
+
+	/* copy response data to user */
+	if (copy_to_user(
+			(void __user *)multi.rsp,
+			rsp,
+			multi.done * sizeof(struct vspm_if_cb_rsp_t))) {
+		EPRINT("CB_MULTI: failed to copy the response\n");
+		ercd = -EFAULT;
+	}
+	if (copy_to_user((void __user *)arg, &multi, _IOC_SIZE(cmd))) {
+		EPRINT("CB_MULTI: failed to copy the response\n");
+		ercd = -EFAULT;
 	}
 
+	kfree(rsp);
 	return ercd;
 }
 
@@ -523,7 +2877,13 @@ static long vspm_ioctl_stop_thread(struct vspm_if_private_t *priv)
 	/* release callback data */
 	release_all_cb_data(priv);
 
-	complete(&priv->wait_interrupt);
+	notify_cb_data(priv);
+
+	/* wake up waiter of completion queue */
+	if (priv->cq) {
+		WRITE_ONCE(priv->cq->stop, 1);
+		wake_up(&priv->cq->wait);
+	}
 
 	return 0;
 }
@@ -552,6 +2912,78 @@ static long unlocked_ioctl(
 	case VSPM_IOC_CMD_ENTRY:
 		ercd = vspm_ioctl_entry(priv, cmd, arg);
 		break;
+	case VSPM_IOC_CMD_ENTRY_BATCH:
+		ercd = vspm_ioctl_entry_batch(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_ENTRY_V2:
+		ercd = vspm_ioctl_entry_v2(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_TMPL_REGISTER:
+		ercd = vspm_ioctl_tmpl_register(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_TMPL_UNREGISTER:
+		ercd = vspm_ioctl_tmpl_unregister(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_TMPL_ENTRY:
+		ercd = vspm_ioctl_tmpl_entry(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_SQ_SETUP:
+		ercd = vspm_ioctl_sq_setup(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_SQ_ENTER:
+		ercd = vspm_ioctl_sq_enter(priv);
+		break;
+	case VSPM_IOC_CMD_CQ_SETUP:
+		ercd = vspm_ioctl_cq_setup(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_CQ_WAIT:
+		ercd = vspm_ioctl_cq_wait(priv);
+		break;
+	case VSPM_IOC_CMD_SET_CONFIG:
+		ercd = vspm_ioctl_set_config(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_GET_STATS:
+		ercd = vspm_ioctl_get_stats(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_TBL_REGISTER:
+		ercd = vspm_ioctl_tbl_register(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_TBL_UNREGISTER:
+		ercd = vspm_ioctl_tbl_unregister(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_DMABUF_IMPORT:
+		ercd = vspm_ioctl_dmabuf_import(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_DMABUF_RELEASE:
+		ercd = vspm_ioctl_dmabuf_release(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_BUF_REGISTER:
+		ercd = vspm_ioctl_buf_register(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_BUF_UNREGISTER:
+		ercd = vspm_ioctl_buf_unregister(priv);
+		break;
+	case VSPM_IOC_CMD_BUF_ALLOC:
+		ercd = vspm_ioctl_buf_alloc(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_USERPTR_MAP:
+		ercd = vspm_ioctl_userptr_map(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_USERPTR_UNMAP:
+		ercd = vspm_ioctl_userptr_unmap(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_ENTRY_FENCE:
+		ercd = vspm_ioctl_entry_fence(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_ENTRY_GRAPH:
+		ercd = vspm_ioctl_entry_graph(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_PIPE_INIT:
+		ercd = vspm_ioctl_pipe_init(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_ENTRY_PIPE:
+		ercd = vspm_ioctl_entry_pipe(priv, cmd, arg);
+		break;
 	case VSPM_IOC_CMD_CANCEL:
 		ercd = vspm_ioctl_cancel(priv, cmd, arg);
 		break;
@@ -561,6 +2993,9 @@ static long unlocked_ioctl(
 	case VSPM_IOC_CMD_WAIT_INTERRUPT:
 		ercd = vspm_ioctl_wait_interrupt(priv, cmd, arg);
 		break;
+	case VSPM_IOC_CMD_WAIT_INTERRUPT_MULTI:
+		ercd = vspm_ioctl_wait_interrupt_multi(priv, cmd, arg);
+		break;
 	case VSPM_IOC_CMD_WAIT_THREAD:
 		ercd = vspm_ioctl_wait_thread(priv);
 		break;
@@ -635,12 +3070,41 @@ static long vspm_ioctl_init32(
 		return -EFAULT;
 	}
 
-	priv->handle = handle;
-	return 0;
+	return set_handle(priv, handle, init_par.type);
+}
+
+static int set_compat_entry_par(
+	struct vspm_if_entry_data_t *entry_data,
+	struct vspm_compat_entry_req_t *compat_req)
+{
+	/* for 64bit */
+	struct vspm_if_entry_req_t *entry_req = &entry_data->entry.req;
+
+	/* for 32bit */
+	struct vspm_compat_job_t compat_job;
+
+	entry_req->priority = compat_req->priority;
+	entry_req->user_data = VSPM_IF_INT_TO_VP(compat_req->user_data);
+	entry_req->cb_func = VSPM_IF_INT_TO_CP(compat_req->cb_func);
+
+	if (compat_req->job_param == 0)
+		return 0;
+
+	/* copy job parameter */
+	if (copy_from_user(
+			&compat_job,
+			VSPM_IF_INT_TO_UP(compat_req->job_param),
+			sizeof(struct vspm_compat_job_t))) {
+		EPRINT("ENTRY32: failed to copy the job parameter\n");
+		return -EFAULT;
+	}
+
+	return set_compat_job_par(entry_data, NULL, &compat_job);
 }
 
-static long vspm_ioctl_entry32(
-	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+static int entry_one32(
+	struct vspm_if_private_t *priv,
+	struct vspm_compat_entry_t *compat_entry)
 {
 	/* for 64bit */
 	struct vspm_if_entry_data_t *entry_data;
@@ -648,99 +3112,34 @@ static long vspm_ioctl_entry32(
 	struct vspm_if_entry_rsp_t entry_rsp;
 
 	/* for 32bit */
-	struct vspm_compat_entry_t compat_entry;
-	struct vspm_compat_job_t compat_job;
-	struct vspm_compat_entry_req_t *compat_req = &compat_entry.req;
-	struct vspm_compat_entry_rsp_t *compat_rsp = &compat_entry.rsp;
+	struct vspm_compat_entry_rsp_t *compat_rsp = &compat_entry->rsp;
 
-	unsigned long lock_flag;
-	int ercd = 0;
+	int ercd;
 
 	/* allocate entry data */
-	entry_data = kzalloc(sizeof(struct vspm_if_entry_data_t), GFP_KERNEL);
+	entry_data = alloc_entry_data(priv);
 	if (!entry_data)
 		return -ENOMEM;
-	entry_data->priv = priv;
-
-	/* add list */
-	spin_lock_irqsave(&priv->lock, lock_flag);
-	list_add_tail(&entry_data->list, &priv->entry_data.list);
-	spin_unlock_irqrestore(&priv->lock, lock_flag);
 
 	entry_req = &entry_data->entry.req;
 
-	/* copy entry parameter */
-	if (copy_from_user(
-			&compat_entry, (void __user *)arg, _IOC_SIZE(cmd))) {
-		EPRINT("ENTRY32: failed to copy the entry parameter\n");
-		ercd = -EFAULT;
+	/* copy job parameter */
+	ercd = set_compat_entry_par(entry_data, &compat_entry->req);
+	if (ercd)
 		goto err_exit;
-	}
-
-	entry_req->priority = compat_req->priority;
-	entry_req->user_data = VSPM_IF_INT_TO_VP(compat_req->user_data);
-	entry_req->cb_func = VSPM_IF_INT_TO_CP(compat_req->cb_func);
-
-	if (compat_req->job_param != 0) {
-		/* copy job parameter */
-		if (copy_from_user(
-				&compat_job,
-				VSPM_IF_INT_TO_UP(compat_req->job_param),
-				sizeof(struct vspm_compat_job_t))) {
-			EPRINT("ENTRY32: failed to copy the job parameter\n");
-			ercd = -EFAULT;
-			goto err_exit;
-		}
-		entry_data->job.type = compat_job.type;
-
-		switch (compat_job.type) {
-		case VSPM_TYPE_VSP_AUTO:
-			/* copy start parameter of VSP */
-			if (compat_job.par.vsp) {
-				ercd = set_compat_vsp_par(
-					entry_data, compat_job.par.vsp);
-				if (ercd)
-					goto err_exit;
-
-				entry_data->job.par.vsp =
-					&entry_data->ip_par.vsp.par;
-			}
-			break;
-		case VSPM_TYPE_FDP_AUTO:
-			/* copy start parameter of FDP */
-			if (compat_job.par.fdp) {
-				ercd = set_compat_fdp_par(
-					entry_data, compat_job.par.fdp);
-				if (ercd)
-					goto err_exit;
-
-				entry_data->job.par.fdp =
-					&entry_data->ip_par.fdp.par;
-			}
-			break;
-		default:
-			break;
-		}
-
-		entry_req->job_param = &entry_data->job;
-	}
 
 	/* entry job */
 	entry_rsp.ercd = vspm_entry_job(
-		priv->handle,
+		job_handle(priv, entry_data),
 		&entry_rsp.job_id,
 		entry_req->priority,
 		entry_req->job_param,
 		(void *)entry_data,
 		vspm_cb_func);
 
-	/* copy result to user */
+	/* set result */
 	compat_rsp->ercd = (int)entry_rsp.ercd;
 	compat_rsp->job_id = (unsigned int)entry_rsp.job_id;
-	if (copy_to_user(
-			(void __user *)arg, &compat_entry, _IOC_SIZE(cmd))) {
-		APRINT("ENTRY32: failed to copy the result\n");
-	}
 
 	if (entry_rsp.ercd != R_VSPM_OK)
 		goto err_exit;
@@ -748,14 +3147,103 @@ static long vspm_ioctl_entry32(
 	return 0;
 
 err_exit:
-	spin_lock_irqsave(&priv->lock, lock_flag);
-	list_del(&entry_data->list);
-	spin_unlock_irqrestore(&priv->lock, lock_flag);
+	free_entry_data(entry_data);
+	return ercd;
+}
 
-	if (entry_data->job.type == VSPM_TYPE_VSP_AUTO)
-		free_vsp_par(&entry_data->ip_par.vsp);
-	kfree(entry_data);
+static long vspm_ioctl_entry32(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	/* for 32bit */
+	struct vspm_compat_entry_t compat_entry;
+
+	int ercd;
+
+	/* copy entry parameter */
+	if (copy_from_user(
+			&compat_entry, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("ENTRY32: failed to copy the entry parameter\n");
+		return -EFAULT;
+	}
+
+	/* entry job */
+	ercd = entry_one32(priv, &compat_entry);
+	if (ercd)
+		return ercd;
+
+	/* copy result to user */
+	if (copy_to_user(
+			(void __user *)arg, &compat_entry, _IOC_SIZE(cmd))) {
+		APRINT("ENTRY32: failed to copy the result\n");
+	}
+
+	return 0;
+}
+
+static long vspm_ioctl_entry_batch32(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	/* for 32bit */
+	struct vspm_compat_entry_batch_t compat_batch;
+	struct vspm_compat_entry_t *compat_entry;
+
+	unsigned int i;
+	int ercd = 0;
+
+	/* copy batch parameter */
+	if (copy_from_user(
+			&compat_batch, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("BATCH32: failed to copy the batch parameter\n");
+		return -EFAULT;
+	}
+
+	if (compat_batch.num == 0 ||
+	    compat_batch.num > VSPM_IF_ENTRY_BATCH_MAX)
+		return -EINVAL;
+
+	compat_entry = kmalloc_array(
+		compat_batch.num,
+		sizeof(struct vspm_compat_entry_t),
+		GFP_KERNEL);
+	if (!compat_entry)
+		return -ENOMEM;
+
+	/* copy entry parameters at once */
+	if (copy_from_user(
+			compat_entry,
+			VSPM_IF_INT_TO_UP(compat_batch.entry),
+			compat_batch.num * sizeof(struct vspm_compat_entry_t))) {
+		EPRINT("BATCH32: failed to copy the entry parameter\n");
+		kfree(compat_entry);
+		return -EFAULT;
+	}
+
+	/* entry jobs until the first failure */
+	for (i = 0; i < compat_batch.num; i++) {
+		ercd = entry_one32(priv, &compat_entry[i]);
+		if (ercd)
+			break;
+		if (compat_entry[i].rsp.ercd != R_VSPM_OK) {
+			i++;
+			break;
+		}
+	}
+	compat_batch.done = i;
+
+	/* copy results to user */
+	if (compat_batch.done) {
+		if (copy_to_user(
+				VSPM_IF_INT_TO_UP(compat_batch.entry),
+				compat_entry,
+				compat_batch.done *
+				sizeof(struct vspm_compat_entry_t)))
+			APRINT("BATCH32: failed to copy the result\n");
+	}
+	if (copy_to_user(
+			(void __user *)arg, &compat_batch, _IOC_SIZE(cmd)))
+		APRINT("BATCH32: failed to copy the result\n");
 
+	kfree(compat_entry);
 	return ercd;
 }
 
@@ -853,39 +3341,8 @@ static long vspm_ioctl_wait_interrupt32(
 		list_del(&cb_data->list);
 		spin_unlock_irqrestore(&priv->lock, lock_flag);
 
-		/* HGO result */
-		if (cb_data->vsp_hgo.virt_addr) {
-			unsigned long tmp_addr =
-				(unsigned long)(cb_data->vsp_hgo.virt_addr);
-			tmp_addr = (tmp_addr + 255) >> 8;
-			/* copy to user area */
-			if (cb_data->vsp_hgo.user_addr) {
-				if (copy_to_user((void __user *)
-						cb_data->vsp_hgo.user_addr,
-						(void *)(tmp_addr << 8),
-						1088)) {
-					APRINT(
-						"CB32: failed to copy HGO data\n");
-				}
-			}
-		}
-
-		/* HGT result */
-		if (cb_data->vsp_hgt.virt_addr) {
-			unsigned long tmp_addr =
-				(unsigned long)(cb_data->vsp_hgt.virt_addr);
-			tmp_addr = (tmp_addr + 255) >> 8;
-			/* copy to user area */
-			if (cb_data->vsp_hgt.user_addr) {
-				if (copy_to_user((void __user *)
-						cb_data->vsp_hgt.user_addr,
-						(void *)(tmp_addr << 8),
-						800)) {
-					APRINT(
-						"CB32: failed to copy HGT data\n");
-				}
-			}
-		}
+		/* copy histogram results */
+		copy_cb_vsp_result(cb_data);
 
 		compat_rsp.ercd = (int)cb_data->rsp.ercd;
 		compat_rsp.cb_func = VSPM_IF_CP_TO_INT(cb_data->rsp.cb_func);
@@ -904,10 +3361,97 @@ static long vspm_ioctl_wait_interrupt32(
 		}
 
 		/* release memory */
-		free_cb_vsp_par(cb_data);
-		kfree(cb_data);
+		free_cb_data(cb_data);
+	}
+
+	return ercd;
+}
+
+static long vspm_ioctl_wait_interrupt_multi32(
+	struct vspm_if_private_t *priv, unsigned int cmd, unsigned long arg)
+{
+	/* for 32bit */
+	struct vspm_compat_cb_multi_t compat_multi;
+	struct vspm_compat_cb_rsp_t *compat_rsp;
+
+	struct vspm_if_cb_data_t *cb_data;
+	struct vspm_if_cb_data_t *next;
+	LIST_HEAD(list);
+
+	unsigned int i = 0;
+	long ercd = 0;
+
+	/* copy multi parameter */
+	if (copy_from_user(
+			&compat_multi, (void __user *)arg, _IOC_SIZE(cmd))) {
+		EPRINT("CB_MULTI32: failed to copy the multi parameter\n");
+		return -EFAULT;
+	}
+
+	if (compat_multi.num == 0 ||
+	    compat_multi.num > VSPM_IF_CB_MULTI_MAX)
+		return -EINVAL;
+
+	compat_rsp = kmalloc_array(
+		compat_multi.num,
+		sizeof(struct vspm_compat_cb_rsp_t),
+		GFP_KERNEL);
+	if (!compat_rsp)
+		return -ENOMEM;
+
+	/* get user process information */
+	priv->thread = current;
+	complete(&priv->wait_thread);
+
+	/* wait process end */
+	if (wait_for_completion_interruptible(&priv->wait_interrupt)) {
+		kfree(compat_rsp);
+		return -EINTR;
+	}
+
+	/* get response data at once */
+	compat_multi.done = take_cb_data(priv, &list, compat_multi.num);
+	if (!compat_multi.done) {
+		/* set response data (ercd = -1) */
+		memset(&compat_rsp[0], 0, sizeof(struct vspm_compat_cb_rsp_t));
+		compat_rsp[0].ercd = -1;
+		compat_multi.done = 1;
+	}
+
+	list_for_each_entry_safe(cb_data, next, &list, list) {
+		/* copy histogram results */
+		copy_cb_vsp_result(cb_data);
+
+		compat_rsp[i].ercd = (int)cb_data->rsp.ercd;
+		compat_rsp[i].cb_func =
+			VSPM_IF_CP_TO_INT(cb_data->rsp.cb_func);
+		compat_rsp[i].job_id = (unsigned int)cb_data->rsp.job_id;
+		compat_rsp[i].result = (int)cb_data->rsp.result;
+		compat_rsp[i].user_data =
+			(unsigned int)(unsigned long)cb_data->rsp.user_data;
+		i++;
+
+		/* release memory */
+		list_del(&cb_data->list);
+		free_cb_data(cb_data);
+	}
+
+	/* copy response data to user */
+	if (copy_to_user(
+			VSPM_IF_INT_TO_UP(compat_multi.rsp),
+			compat_rsp,
+			compat_multi.done *
+			sizeof(struct vspm_compat_cb_rsp_t))) {
+		EPRINT("CB_MULTI32: failed to copy the response\n");
+		ercd = -EFAULT;
+	}
+	if (copy_to_user(
+			(void __user *)arg, &compat_multi, _IOC_SIZE(cmd))) {
+		EPRINT("CB_MULTI32: failed to copy the response\n");
+		ercd = -EFAULT;
 	}
 
+	kfree(compat_rsp);
 	return ercd;
 }
 
@@ -934,6 +3478,78 @@ static long compat_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 	case VSPM_IOC_CMD_ENTRY32:
 		ercd = vspm_ioctl_entry32(priv, cmd, arg);
 		break;
+	case VSPM_IOC_CMD_ENTRY_BATCH32:
+		ercd = vspm_ioctl_entry_batch32(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_ENTRY_V2:
+		ercd = vspm_ioctl_entry_v2(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_TMPL_REGISTER:
+		ercd = vspm_ioctl_tmpl_register(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_TMPL_UNREGISTER:
+		ercd = vspm_ioctl_tmpl_unregister(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_TMPL_ENTRY:
+		ercd = vspm_ioctl_tmpl_entry(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_SQ_SETUP:
+		ercd = vspm_ioctl_sq_setup(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_SQ_ENTER:
+		ercd = vspm_ioctl_sq_enter(priv);
+		break;
+	case VSPM_IOC_CMD_CQ_SETUP:
+		ercd = vspm_ioctl_cq_setup(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_CQ_WAIT:
+		ercd = vspm_ioctl_cq_wait(priv);
+		break;
+	case VSPM_IOC_CMD_SET_CONFIG:
+		ercd = vspm_ioctl_set_config(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_GET_STATS:
+		ercd = vspm_ioctl_get_stats(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_TBL_REGISTER:
+		ercd = vspm_ioctl_tbl_register(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_TBL_UNREGISTER:
+		ercd = vspm_ioctl_tbl_unregister(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_DMABUF_IMPORT:
+		ercd = vspm_ioctl_dmabuf_import(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_DMABUF_RELEASE:
+		ercd = vspm_ioctl_dmabuf_release(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_BUF_REGISTER:
+		ercd = vspm_ioctl_buf_register(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_BUF_UNREGISTER:
+		ercd = vspm_ioctl_buf_unregister(priv);
+		break;
+	case VSPM_IOC_CMD_BUF_ALLOC:
+		ercd = vspm_ioctl_buf_alloc(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_USERPTR_MAP:
+		ercd = vspm_ioctl_userptr_map(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_USERPTR_UNMAP:
+		ercd = vspm_ioctl_userptr_unmap(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_ENTRY_FENCE:
+		ercd = vspm_ioctl_entry_fence(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_ENTRY_GRAPH:
+		ercd = vspm_ioctl_entry_graph(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_PIPE_INIT:
+		ercd = vspm_ioctl_pipe_init(priv, cmd, arg);
+		break;
+	case VSPM_IOC_CMD_ENTRY_PIPE:
+		ercd = vspm_ioctl_entry_pipe(priv, cmd, arg);
+		break;
 	case VSPM_IOC_CMD_CANCEL32:
 		ercd = vspm_ioctl_cancel(priv, cmd, arg);
 		break;
@@ -943,6 +3559,9 @@ static long compat_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 	case VSPM_IOC_CMD_WAIT_INTERRUPT32:
 		ercd = vspm_ioctl_wait_interrupt32(priv, cmd, arg);
 		break;
+	case VSPM_IOC_CMD_WAIT_INTERRUPT_MULTI32:
+		ercd = vspm_ioctl_wait_interrupt_multi32(priv, cmd, arg);
+		break;
 	case VSPM_IOC_CMD_WAIT_THREAD:
 		ercd = vspm_ioctl_wait_thread(priv);
 		break;
@@ -957,12 +3576,143 @@ static long compat_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 	return ercd;
 }
 
+static int mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct vspm_if_private_t *priv =
+		(struct vspm_if_private_t *)file->private_data;
+	unsigned long size = vma->vm_end - vma->vm_start;
+
+	/* check parameter */
+	if (!priv) {
+		EPRINT("MMAP: invalid private data!!\n");
+		return -EFAULT;
+	}
+
+	if (vma->vm_pgoff == (VSPM_IF_MMAP_SQ_RING >> PAGE_SHIFT)) {
+		if (!priv->sq || size > priv->sq->ring_size)
+			return -EINVAL;
+		return remap_vmalloc_range(vma, priv->sq->ring, 0);
+	}
+
+	if (vma->vm_pgoff == (VSPM_IF_MMAP_CQ_RING >> PAGE_SHIFT)) {
+		if (!priv->cq || size > priv->cq->ring_size)
+			return -EINVAL;
+		return remap_vmalloc_range(vma, priv->cq->ring, 0);
+	}
+
+	return -EINVAL;
+}
+
+static ssize_t read(
+	struct file *file, char __user *buf, size_t count, loff_t *ppos)
+{
+	struct vspm_if_private_t *priv =
+		(struct vspm_if_private_t *)file->private_data;
+	struct vspm_if_cb_data_t *cb_data;
+	struct vspm_if_cb_data_t *next;
+	LIST_HEAD(list);
+
+	struct vspm_if_cb_rsp_t rsp;
+	struct vspm_compat_cb_rsp_t compat_rsp;
+	size_t size;
+	void *src;
+
+	unsigned int num;
+	unsigned int i = 0;
+	ssize_t ercd;
+
+	/* check parameter */
+	if (!priv) {
+		EPRINT("READ: invalid private data!!\n");
+		return -EFAULT;
+	}
+
+	/* size of a response record */
+	if (in_compat_syscall()) {
+		size = sizeof(struct vspm_compat_cb_rsp_t);
+		src = &compat_rsp;
+	} else {
+		size = sizeof(struct vspm_if_cb_rsp_t);
+		src = &rsp;
+	}
+
+	num = min_t(size_t, count / size, VSPM_IF_CB_MULTI_MAX);
+	if (num == 0)
+		return -EINVAL;
+
+	/* wait process end */
+	if (file->f_flags & O_NONBLOCK) {
+		if (!try_wait_for_completion(&priv->wait_interrupt))
+			return -EAGAIN;
+	} else {
+		if (wait_for_completion_interruptible(&priv->wait_interrupt))
+			return -ERESTARTSYS;
+	}
+
+	/* get response data at once */
+	/* (stopped by VSPM_IOC_CMD_STOP_THREAD if there is nothing) */
+	num = take_cb_data(priv, &list, num);
+	ercd = num * size;
+
+	list_for_each_entry_safe(cb_data, next, &list, list) {
+		/* copy histogram results */
+		copy_cb_vsp_result(cb_data);
+
+		rsp = cb_data->rsp;
+		compat_rsp.ercd = (int)rsp.ercd;
+		compat_rsp.cb_func = VSPM_IF_CP_TO_INT(rsp.cb_func);
+		compat_rsp.job_id = (unsigned int)rsp.job_id;
+		compat_rsp.result = (int)rsp.result;
+		compat_rsp.user_data =
+			(unsigned int)(unsigned long)rsp.user_data;
+
+		/* copy response data to user */
+		if (copy_to_user(buf + i * size, src, size)) {
+			EPRINT("READ: failed to copy the response\n");
+			ercd = -EFAULT;
+		}
+		i++;
+
+		/* release memory */
+		list_del(&cb_data->list);
+		free_cb_data(cb_data);
+	}
+
+	return ercd;
+}
+
+static __poll_t poll(struct file *file, poll_table *wait)
+{
+	struct vspm_if_private_t *priv =
+		(struct vspm_if_private_t *)file->private_data;
+	__poll_t mask = 0;
+
+	/* check parameter */
+	if (!priv)
+		return EPOLLERR;
+
+	poll_wait(file, &priv->poll_wait, wait);
+	if (priv->cq)
+		poll_wait(file, &priv->cq->wait, wait);
+
+	/* callback data (or stop request) and completion queue */
+	if (completion_done(&priv->wait_interrupt))
+		mask |= EPOLLIN | EPOLLRDNORM;
+	if (priv->cq && cq_ready(priv->cq))
+		mask |= EPOLLIN | EPOLLRDNORM;
+
+	return mask;
+}
+
 static const struct file_operations fops = {
 	.owner   = THIS_MODULE,
 	.open    = open,
 	.release = close,
 	.unlocked_ioctl = unlocked_ioctl,
 	.compat_ioctl = compat_ioctl,
+	.mmap    = mmap,
+	.read    = read,
+	.poll    = poll,
 };
 
 static struct miscdevice misc = {
@@ -976,6 +3726,13 @@ static int vspm_if_probe(struct platform_device *pdev)
 	if (g_vspmif_pdev)
 		return -1;
 
+	/* DMA memory of the driver is limited to what VSP can address */
+	/* (with IOMMU, the pages themselves can be anywhere) */
+	if (dma_set_mask_and_coherent(&pdev->dev, VSPM_IF_DMA_MASK)) {
+		EPRINT("failed to set DMA mask\n");
+		return -EIO;
+	}
+
 	g_vspmif_pdev = pdev;
 	return 0;
 }
@@ -1005,12 +3762,26 @@ static int vspm_if_init(void)
 {
 	g_vspmif_pdev = NULL;
 
+	g_vspmif_entry_cache = kmem_cache_create(
+		"vspm_if_entry_data",
+		sizeof(struct vspm_if_entry_data_t),
+		0, 0, NULL);
+	if (!g_vspmif_entry_cache)
+		return -ENOMEM;
+
 	platform_driver_register(&vspm_if_driver);
 	if (!g_vspmif_pdev) {
 		platform_driver_unregister(&vspm_if_driver);
+		kmem_cache_destroy(g_vspmif_entry_cache);
 		return -ENODEV;
 	}
 
+	if (init_work_mem_pools(&g_vspmif_pdev->dev)) {
+		platform_driver_unregister(&vspm_if_driver);
+		kmem_cache_destroy(g_vspmif_entry_cache);
+		return -ENOMEM;
+	}
+
 	misc_register(&misc);
 
 	return 0;
@@ -1020,7 +3791,12 @@ static void vspm_if_exit(void)
 {
 	misc_deregister(&misc);
 
+	flush_deferred_free();
+	release_work_mem_pools();
+
 	platform_driver_unregister(&vspm_if_driver);
+
+	kmem_cache_destroy(g_vspmif_entry_cache);
 }
 
 module_init(vspm_if_init);
@@ -61,6 +61,16 @@
 #include <linux/platform_device.h>
 #include <linux/slab.h>
 #include <linux/dma-mapping.h>
+#include <linux/dmapool.h>
+#include <linux/percpu.h>
+#include <linux/shrinker.h>
+#include <linux/vmalloc.h>
+#include <linux/kthread.h>
+#include <linux/workqueue.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-fence.h>
+#include <linux/sync_file.h>
+#include <linux/mm.h>
 
 #include "vspm_public.h"
 #include "vspm_if.h"
@@ -70,481 +80,1175 @@ void release_all_entry_data(struct vspm_if_private_t *priv)
 {
 	struct vspm_if_entry_data_t *entry_data;
 	struct vspm_if_entry_data_t *next;
+	LIST_HEAD(list);
 
 	unsigned long lock_flag;
 
 	spin_lock_irqsave(&priv->lock, lock_flag);
-	list_for_each_entry_safe(
-		entry_data, next, &priv->entry_data.list, list) {
+	list_splice_init(&priv->entry_data.list, &list);
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+
+	/* work buffers and templates take their own locks */
+	list_for_each_entry_safe(entry_data, next, &list, list) {
 		list_del(&entry_data->list);
 		if (entry_data->job.type == VSPM_TYPE_VSP_AUTO)
 			free_vsp_par(&entry_data->ip_par.vsp);
-		kfree(entry_data);
+		put_tmpl(entry_data->tmpl);
+		put_buf_table(entry_data->buf_table);
+		signal_out_fence(&entry_data->fence, -ECANCELED);
+		kmem_cache_free(g_vspmif_entry_cache, entry_data);
 	}
-	spin_unlock_irqrestore(&priv->lock, lock_flag);
 }
 
 void release_all_cb_data(struct vspm_if_private_t *priv)
 {
 	struct vspm_if_cb_data_t *cb_data;
 	struct vspm_if_cb_data_t *next;
+	LIST_HEAD(list);
 
 	unsigned long lock_flag;
 
 	spin_lock_irqsave(&priv->lock, lock_flag);
-	list_for_each_entry_safe(cb_data, next, &priv->cb_data.list, list) {
+	list_splice_init(&priv->cb_data.list, &list);
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+
+	list_for_each_entry_safe(cb_data, next, &list, list) {
 		list_del(&cb_data->list);
-		free_cb_vsp_par(cb_data);
-		kfree(cb_data);
+		free_cb_data(cb_data);
 	}
-	spin_unlock_irqrestore(&priv->lock, lock_flag);
 }
 
-struct vspm_if_work_buff_t *get_work_buffer(struct vspm_if_private_t *priv)
+void release_sq(struct vspm_if_private_t *priv)
 {
-	struct vspm_if_work_buff_t *cur_buff = NULL;
-	struct vspm_if_work_buff_t *prev_buff = NULL;
+	struct vspm_if_sq_t *sq = priv->sq;
 
-	down(&priv->sem);
+	if (!sq)
+		return;
 
-	/* search unused work buffer */
-	cur_buff = priv->work_buff;
-	while (cur_buff) {
-		if (cur_buff->use_flag == 0) {
-			/* set work buffer */
-			cur_buff->use_flag = 1;
-			cur_buff->offset = 0;
-			up(&priv->sem);
-			return cur_buff;
+	/* stop polling thread */
+	if (sq->thread)
+		(void)kthread_stop(sq->thread);
+
+	/* release memory */
+	if (sq->err_rec)
+		put_entry_data(sq->err_rec);
+	vfree(sq->ring);
+	kfree(sq->desc);
+	kfree(sq);
+
+	priv->sq = NULL;
+}
+
+void release_cq(struct vspm_if_private_t *priv)
+{
+	struct vspm_if_cq_t *cq = priv->cq;
+
+	if (!cq)
+		return;
+
+	/* release memory */
+	vfree(cq->ring);
+	kfree(cq);
+
+	priv->cq = NULL;
+}
+
+int init_entry_pool(struct vspm_if_private_t *priv)
+{
+	struct vspm_if_entry_pool_t *pool = &priv->entry_pool;
+	struct vspm_if_entry_data_t *entry_data;
+
+	unsigned long lock_flag;
+	unsigned int depth = priv->config.entry_pool_depth;
+	unsigned int i;
+
+	/* already preallocated */
+	if (pool->depth)
+		return 0;
+
+	if (!depth)
+		depth = VSPM_IF_ENTRY_POOL_DEPTH;
+
+	/* preallocate entry data */
+	for (i = 0; i < depth; i++) {
+		entry_data = kmem_cache_alloc(
+			g_vspmif_entry_cache, GFP_KERNEL);
+		if (!entry_data) {
+			release_entry_pool(priv);
+			return -ENOMEM;
 		}
 
-		prev_buff = cur_buff;
-		cur_buff = cur_buff->next_buff;
+		spin_lock_irqsave(&priv->lock, lock_flag);
+		list_add_tail(&entry_data->list, &pool->list);
+		pool->depth++;
+		pool->free++;
+		spin_unlock_irqrestore(&priv->lock, lock_flag);
 	}
 
-	/* allocate work buffer */
-	cur_buff = kzalloc(sizeof(struct vspm_if_work_buff_t), GFP_KERNEL);
-	if (!cur_buff) {
-		EPRINT("failed to allocate memory\n");
-		up(&priv->sem);
-		return NULL;
+	return 0;
+}
+
+void release_entry_pool(struct vspm_if_private_t *priv)
+{
+	struct vspm_if_entry_pool_t *pool = &priv->entry_pool;
+	struct vspm_if_entry_data_t *entry_data;
+	struct vspm_if_entry_data_t *next;
+
+	unsigned long lock_flag;
+
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	list_for_each_entry_safe(entry_data, next, &pool->list, list) {
+		list_del(&entry_data->list);
+		kmem_cache_free(g_vspmif_entry_cache, entry_data);
 	}
+	pool->depth = 0;
+	pool->free = 0;
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+}
 
-	cur_buff->virt_addr = dma_alloc_coherent(
-		&g_vspmif_pdev->dev,
-		VSPM_IF_MEM_SIZE,
-		&cur_buff->hard_addr,
-		GFP_KERNEL);
-	if (!cur_buff->virt_addr) {
-		EPRINT("failed to allocate work buffer\n");
-		kfree(cur_buff);
-		up(&priv->sem);
-		return NULL;
+struct vspm_if_entry_data_t *get_entry_data(struct vspm_if_private_t *priv)
+{
+	struct vspm_if_entry_pool_t *pool = &priv->entry_pool;
+	struct vspm_if_entry_data_t *entry_data = NULL;
+
+	unsigned long lock_flag;
+
+	/* get from pool */
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	if (!list_empty(&pool->list)) {
+		entry_data = list_first_entry(
+			&pool->list, struct vspm_if_entry_data_t, list);
+		list_del(&entry_data->list);
+		pool->free--;
+	} else {
+		pool->miss++;
 	}
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
 
-	/* connect work buffer */
-	if (!prev_buff)
-		priv->work_buff = cur_buff;
-	else
-		prev_buff->next_buff = cur_buff;
+	/* allocate out of pool */
+	if (!entry_data) {
+		entry_data = kmem_cache_alloc(
+			g_vspmif_entry_cache, GFP_KERNEL);
+		if (!entry_data)
+			return NULL;
+	}
+
+	/* clear the members that are referred without parameter */
+	entry_data->priv = priv;
+	entry_data->tmpl = NULL;
+	entry_data->buf_table = NULL;
+	entry_data->fence = NULL;
+	memset(&entry_data->entry, 0, sizeof(entry_data->entry));
+	memset(&entry_data->job, 0, sizeof(entry_data->job));
+	entry_data->ip_par.vsp.work_buff = NULL;
+	memset(&entry_data->ip_par.vsp.ctrl.hgo, 0,
+	       sizeof(entry_data->ip_par.vsp.ctrl.hgo));
+	memset(&entry_data->ip_par.vsp.ctrl.hgt, 0,
+	       sizeof(entry_data->ip_par.vsp.ctrl.hgt));
+	memset(&entry_data->cb_data, 0, sizeof(entry_data->cb_data));
+
+	return entry_data;
+}
 
-	/* set work buffer */
-	cur_buff->use_flag = 1;
-	cur_buff->offset = 0;
-	up(&priv->sem);
+void put_entry_data(struct vspm_if_entry_data_t *entry_data)
+{
+	struct vspm_if_private_t *priv = entry_data->priv;
+	struct vspm_if_entry_pool_t *pool = &priv->entry_pool;
 
-	return cur_buff;
+	unsigned long lock_flag;
+
+	/* return to pool */
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	if (pool->free < pool->depth) {
+		list_add(&entry_data->list, &pool->list);
+		pool->free++;
+		entry_data = NULL;
+	}
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+
+	/* allocated out of pool */
+	if (entry_data)
+		kmem_cache_free(g_vspmif_entry_cache, entry_data);
 }
 
-void release_work_buffers(struct vspm_if_private_t *priv)
+/* size class of work memory */
+static const unsigned int work_mem_size[VSPM_IF_MEM_CLASS_NUM] = {
+	VSPM_IF_RPF_CLUT_SIZE,
+	VSPM_IF_HGO_SIZE,
+	VSPM_IF_HGT_SIZE,
+	VSPM_IF_DL_SIZE,
+};
+
+static const char * const work_mem_name[VSPM_IF_MEM_CLASS_NUM] = {
+	"vspm_if_clut",
+	"vspm_if_hgo",
+	"vspm_if_hgt",
+	"vspm_if_dl",
+};
+
+static struct dma_pool *work_mem_pool[VSPM_IF_MEM_CLASS_NUM];
+static struct vspm_if_mem_cache_t work_mem_cache[VSPM_IF_MEM_CLASS_NUM];
+
+static unsigned int prewarm = VSPM_IF_MEM_PREWARM;
+module_param(prewarm, uint, 0444);
+MODULE_PARM_DESC(prewarm, "number of jobs whose work memory is kept");
+
+static unsigned int reclaim_floor = VSPM_IF_MEM_PREWARM;
+module_param(reclaim_floor, uint, 0644);
+MODULE_PARM_DESC(reclaim_floor,
+		 "number of jobs whose work memory is kept on memory pressure");
+
+static atomic64_t work_mem_reclaimed = ATOMIC64_INIT(0);
+static int work_mem_shrinker_registered;
+
+static struct vspm_if_work_mem_t *new_work_mem(unsigned int cls)
 {
-	struct vspm_if_work_buff_t *cur_buff;
-	struct vspm_if_work_buff_t *next_buff;
+	struct vspm_if_work_mem_t *mem;
 
-	down(&priv->sem);
+	mem = kmalloc(sizeof(struct vspm_if_work_mem_t), GFP_KERNEL);
+	if (!mem)
+		return NULL;
 
-	cur_buff = priv->work_buff;
-	while (cur_buff) {
-		next_buff = cur_buff->next_buff;
+	/* display list is page sized, so it is allocated directly */
+	if (cls == VSPM_IF_MEM_DL) {
+		mem->virt_addr = dma_alloc_coherent(
+			&g_vspmif_pdev->dev,
+			work_mem_size[cls],
+			&mem->hard_addr,
+			GFP_KERNEL);
+	} else {
+		mem->virt_addr = dma_pool_alloc(
+			work_mem_pool[cls], GFP_KERNEL, &mem->hard_addr);
+	}
+	if (!mem->virt_addr) {
+		EPRINT("failed to allocate work memory\n");
+		kfree(mem);
+		return NULL;
+	}
+	mem->cls = cls;
 
-		/* release work buffer */
+	return mem;
+}
+
+static void delete_work_mem(struct vspm_if_work_mem_t *mem)
+{
+	if (mem->cls == VSPM_IF_MEM_DL) {
 		dma_free_coherent(
 			&g_vspmif_pdev->dev,
-			VSPM_IF_MEM_SIZE,
-			cur_buff->virt_addr,
-			cur_buff->hard_addr);
+			work_mem_size[mem->cls],
+			mem->virt_addr,
+			mem->hard_addr);
+	} else {
+		dma_pool_free(
+			work_mem_pool[mem->cls],
+			mem->virt_addr,
+			mem->hard_addr);
+	}
+	kfree(mem);
+}
 
-		kfree(cur_buff);
+static struct vspm_if_work_mem_t *get_work_mem(unsigned int cls)
+{
+	struct vspm_if_mem_cache_t *cache = &work_mem_cache[cls];
+	struct vspm_if_mem_pcp_t *pcp;
+	struct vspm_if_work_mem_t *mem = NULL;
 
-		cur_buff = next_buff;
+	unsigned long lock_flag;
+
+	/* get from cache of this CPU */
+	local_irq_save(lock_flag);
+	pcp = this_cpu_ptr(cache->pcp);
+	if (pcp->num)
+		mem = pcp->mem[--pcp->num];
+	local_irq_restore(lock_flag);
+
+	if (mem)
+		return mem;
+
+	/* get from global cache */
+	spin_lock_irqsave(&cache->lock, lock_flag);
+	if (!list_empty(&cache->list)) {
+		mem = list_first_entry(
+			&cache->list, struct vspm_if_work_mem_t, list);
+		list_del(&mem->list);
+		cache->num--;
 	}
-	priv->work_buff = NULL;
-	up(&priv->sem);
+	spin_unlock_irqrestore(&cache->lock, lock_flag);
+
+	if (mem)
+		return mem;
+
+	/* allocate new memory */
+	return new_work_mem(cls);
 }
 
-static int set_vsp_src_clut_par(
-	struct vsp_dl_t *clut,
-	struct vsp_dl_t *src,
-	struct vspm_if_work_buff_t *work_buff)
+static void put_work_mem(struct vspm_if_work_mem_t *mem)
 {
-	unsigned long tmp_addr;
+	struct vspm_if_mem_cache_t *cache = &work_mem_cache[mem->cls];
+	struct vspm_if_mem_pcp_t *pcp;
 
-	/* copy vsp_dl_t parameter */
-	if (copy_from_user(
-			clut,
-			(void __user *)src,
-			sizeof(struct vsp_dl_t))) {
-		EPRINT("failed to copy of vsp_dl_t\n");
-		return -EFAULT;
+	unsigned long lock_flag;
+
+	/* return to cache of this CPU */
+	local_irq_save(lock_flag);
+	pcp = this_cpu_ptr(cache->pcp);
+	if (pcp->num < VSPM_IF_MEM_PCP_SIZE) {
+		pcp->mem[pcp->num++] = mem;
+		mem = NULL;
 	}
+	local_irq_restore(lock_flag);
 
-	if (clut->virt_addr &&
-	    clut->tbl_num > 0 &&
-	    clut->tbl_num <= 256) {
-		tmp_addr =
-			(unsigned long)work_buff->virt_addr +
-			(unsigned long)work_buff->offset;
+	if (!mem)
+		return;
 
-		/* copy color table */
-		if (copy_from_user(
-				(void *)tmp_addr,
-				(void __user *)clut->virt_addr,
-				clut->tbl_num * 8)) {
-			EPRINT("failed to copy of color table\n");
-			return -EFAULT;
-		}
+	/* return to global cache */
+	/* (this may be called from callback, so memory is not freed here) */
+	spin_lock_irqsave(&cache->lock, lock_flag);
+	list_add(&mem->list, &cache->list);
+	cache->num++;
+	spin_unlock_irqrestore(&cache->lock, lock_flag);
+}
 
-		/* set parameter */
-		clut->virt_addr = (void *)tmp_addr;
-		tmp_addr =
-			(unsigned long)work_buff->hard_addr +
-			(unsigned long)work_buff->offset;
-		clut->hard_addr = (unsigned int)tmp_addr;
+static unsigned long trim_work_mem(
+	unsigned int cls, unsigned int target, unsigned long max)
+{
+	struct vspm_if_mem_cache_t *cache = &work_mem_cache[cls];
+	struct vspm_if_work_mem_t *mem;
+
+	unsigned long lock_flag;
+	unsigned long freed = 0;
+
+	/* free memory of global cache beyond target */
+	while (freed < max) {
+		mem = NULL;
+		spin_lock_irqsave(&cache->lock, lock_flag);
+		if (cache->num > target) {
+			mem = list_first_entry(
+				&cache->list, struct vspm_if_work_mem_t, list);
+			list_del(&mem->list);
+			cache->num--;
+		}
+		spin_unlock_irqrestore(&cache->lock, lock_flag);
 
-		/* increment memory offset */
-		work_buff->offset += VSPM_IF_RPF_CLUT_SIZE;
+		if (!mem)
+			break;
+		delete_work_mem(mem);
+		atomic64_add(work_mem_size[cls], &work_mem_reclaimed);
+		freed++;
 	}
 
-	return 0;
+	return freed;
 }
 
-static int set_vsp_src_alpha_par(
-	struct vspm_entry_vsp_in_alpha *alpha, struct vsp_alpha_unit_t *src)
+void trim_work_mem_cache(void)
 {
-	/* copy vsp_alpha_unit_t parameter */
-	if (copy_from_user(
-			&alpha->alpha,
-			(void __user *)src,
-			sizeof(struct vsp_alpha_unit_t))) {
-		EPRINT("failed to copy of vsp_alpha_unit_t\n");
-		return -EFAULT;
-	}
+	int i;
 
-	/* copy vsp_irop_unit_t paramerter */
-	if (alpha->alpha.irop) {
-		if (copy_from_user(
-				&alpha->irop,
-				(void __user *)alpha->alpha.irop,
-				sizeof(struct vsp_irop_unit_t))) {
-			EPRINT("failed to copy of vsp_irop_unit_t\n");
-			return -EFAULT;
-		}
-		alpha->alpha.irop = &alpha->irop;
-	}
+	for (i = 0; i < VSPM_IF_MEM_CLASS_NUM; i++)
+		(void)trim_work_mem(i, prewarm, ULONG_MAX);
+}
 
-	/* copy vsp_ckey_unit_t paramerter */
-	if (alpha->alpha.ckey) {
-		if (copy_from_user(
-				&alpha->ckey,
-				(void __user *)alpha->alpha.ckey,
-				sizeof(struct vsp_ckey_unit_t))) {
-			EPRINT("failed to copy of vsp_ckey_unit_t\n");
-			return -EFAULT;
-		}
-		alpha->alpha.ckey = &alpha->ckey;
-	}
+static unsigned long count_work_mem(
+	struct shrinker *shrink, struct shrink_control *sc)
+{
+	unsigned int floor = READ_ONCE(reclaim_floor);
+	unsigned long count = 0;
+	unsigned int num;
+	int i;
 
-	/* copy vsp_mult_unit_t paramerter */
-	if (alpha->alpha.mult) {
-		if (copy_from_user(
-				&alpha->mult,
-				(void __user *)alpha->alpha.mult,
-				sizeof(struct vsp_mult_unit_t))) {
-			EPRINT("failed to copy of vsp_mult_unit_t\n");
-			return -EFAULT;
-		}
-		alpha->alpha.mult = &alpha->mult;
+	/* idle memory beyond floor */
+	for (i = 0; i < VSPM_IF_MEM_CLASS_NUM; i++) {
+		num = READ_ONCE(work_mem_cache[i].num);
+		if (num > floor)
+			count += num - floor;
 	}
 
-	return 0;
+	return count;
 }
 
-static int set_vsp_src_par(
-	struct vspm_entry_vsp_in *in,
-	struct vsp_src_t *src,
-	struct vspm_if_work_buff_t *work_buff)
+static unsigned long scan_work_mem(
+	struct shrinker *shrink, struct shrink_control *sc)
 {
-	int ercd;
+	unsigned int floor = READ_ONCE(reclaim_floor);
+	unsigned long freed = 0;
+	int i;
 
-	/* copy vsp_src_t parameter */
-	if (copy_from_user(
-			&in->in,
-			(void __user *)src,
-			sizeof(struct vsp_src_t))) {
-		EPRINT("failed to copy of vsp_src_t\n");
-		return -EFAULT;
+	/* the biggest class (display list) first */
+	for (i = VSPM_IF_MEM_CLASS_NUM - 1; i >= 0; i--) {
+		if (freed >= sc->nr_to_scan)
+			break;
+		freed += trim_work_mem(i, floor, sc->nr_to_scan - freed);
 	}
 
-	/* copy vsp_dl_t parameter */
-	if (in->in.clut) {
-		ercd = set_vsp_src_clut_par(&in->clut, in->in.clut, work_buff);
-		if (ercd)
-			return ercd;
-		in->in.clut = &in->clut;
-	}
+	return freed ? freed : SHRINK_STOP;
+}
 
-	/* copy vsp_alpha_unit_t parameter */
-	if (in->in.alpha) {
-		ercd = set_vsp_src_alpha_par(&in->alpha, in->in.alpha);
-		if (ercd)
-			return ercd;
-		in->in.alpha = &in->alpha.alpha;
-	}
+static struct shrinker work_mem_shrinker = {
+	.count_objects = count_work_mem,
+	.scan_objects = scan_work_mem,
+	.seeks = DEFAULT_SEEKS,
+};
 
-	return 0;
+void get_work_mem_stats(struct vspm_if_stats_t *stats)
+{
+	unsigned int cached = 0;
+	int i;
+
+	for (i = 0; i < VSPM_IF_MEM_CLASS_NUM; i++)
+		cached += READ_ONCE(work_mem_cache[i].num) * work_mem_size[i];
+
+	stats->mem_cached = cached;
+	stats->mem_reclaimed = atomic64_read(&work_mem_reclaimed);
 }
 
-static int set_vsp_dst_par(
-	struct vspm_entry_vsp_out *out, struct vsp_dst_t *src)
+int init_work_mem_pools(struct device *dev)
 {
-	/* copy vsp_dst_t parameter */
-	if (copy_from_user(
-			&out->out,
-			(void __user *)src,
-			sizeof(struct vsp_dst_t))) {
-		EPRINT("failed to copy of vsp_dst_t\n");
-		return -EFAULT;
+	struct vspm_if_mem_cache_t *cache;
+	struct vspm_if_work_mem_t *mem;
+	unsigned int i;
+	unsigned int j;
+
+	for (i = 0; i < VSPM_IF_MEM_CLASS_NUM; i++) {
+		cache = &work_mem_cache[i];
+		spin_lock_init(&cache->lock);
+		INIT_LIST_HEAD(&cache->list);
+		cache->num = 0;
+	}
+
+	for (i = 0; i < VSPM_IF_MEM_CLASS_NUM; i++) {
+		cache = &work_mem_cache[i];
+		cache->pcp = alloc_percpu(struct vspm_if_mem_pcp_t);
+		if (!cache->pcp)
+			goto err_exit;
+
+		if (i == VSPM_IF_MEM_DL)
+			continue;
+
+		work_mem_pool[i] = dma_pool_create(
+			work_mem_name[i],
+			dev,
+			work_mem_size[i],
+			VSPM_IF_MEM_ALIGN,
+			0);
+		if (!work_mem_pool[i]) {
+			EPRINT("failed to create %s pool\n", work_mem_name[i]);
+			goto err_exit;
+		}
 	}
 
-	/* copy fcp_info_t parameter */
-	if (out->out.fcp) {
-		if (copy_from_user(
-				&out->fcp,
-				(void __user *)out->out.fcp,
-				sizeof(struct fcp_info_t))) {
-			EPRINT("failed to copy of fcp_info_t\n");
-			return -EFAULT;
+	/* prewarm global cache */
+	for (i = 0; i < VSPM_IF_MEM_CLASS_NUM; i++) {
+		for (j = 0; j < prewarm; j++) {
+			mem = new_work_mem(i);
+			if (!mem)
+				goto err_exit;
+			list_add(&mem->list, &work_mem_cache[i].list);
+			work_mem_cache[i].num++;
 		}
-		out->out.fcp = &out->fcp;
 	}
 
+	/* release idle memory on memory pressure */
+	if (register_shrinker(&work_mem_shrinker))
+		goto err_exit;
+	work_mem_shrinker_registered = 1;
+
 	return 0;
+
+err_exit:
+	release_work_mem_pools();
+	return -ENOMEM;
 }
 
-static int set_vsp_bru_par(
-	struct vspm_entry_vsp_bru *bru, struct vsp_bru_t *src)
+void release_work_mem_pools(void)
 {
-	struct vsp_bld_ctrl_t **src_blend[5];
+	struct vspm_if_mem_cache_t *cache;
+	struct vspm_if_mem_pcp_t *pcp;
+	int cpu;
 	int i;
 
-	/* copy vsp_bru_t parameter */
-	if (copy_from_user(
-			&bru->bru,
-			(void __user *)src,
-			sizeof(struct vsp_bru_t))) {
-		EPRINT("failed to copy of vsp_bru_t\n");
-		return -EFAULT;
+	if (work_mem_shrinker_registered) {
+		unregister_shrinker(&work_mem_shrinker);
+		work_mem_shrinker_registered = 0;
 	}
 
-	/* copy vsp_bld_dither_t parameter */
-	for (i = 0; i < 5; i++) {
-		if (bru->bru.dither_unit[i]) {
-			if (copy_from_user(
-					&bru->dither_unit[i],
-					(void __user *)bru->bru.dither_unit[i],
-					sizeof(struct vsp_bld_dither_t))) {
-				EPRINT("failed to copy of vsp_bld_dither_t\n");
-				return -EFAULT;
+	for (i = 0; i < VSPM_IF_MEM_CLASS_NUM; i++) {
+		cache = &work_mem_cache[i];
+
+		/* release cache of all CPUs */
+		if (cache->pcp) {
+			for_each_possible_cpu(cpu) {
+				pcp = per_cpu_ptr(cache->pcp, cpu);
+				while (pcp->num)
+					delete_work_mem(pcp->mem[--pcp->num]);
 			}
-			bru->bru.dither_unit[i] = &bru->dither_unit[i];
+			free_percpu(cache->pcp);
+			cache->pcp = NULL;
+		}
+
+		/* release global cache */
+		(void)trim_work_mem(i, 0, ULONG_MAX);
+
+		if (work_mem_pool[i]) {
+			dma_pool_destroy(work_mem_pool[i]);
+			work_mem_pool[i] = NULL;
 		}
 	}
+}
 
-	/* copy vsp_bld_vir_t parameter */
-	if (bru->bru.blend_virtual) {
-		if (copy_from_user(
-				&bru->blend_virtual,
-				(void __user *)bru->bru.blend_virtual,
-				sizeof(struct vsp_bld_vir_t))) {
-			EPRINT("failed to copy of vsp_bld_vir_t\n");
-			return -EFAULT;
-		}
-		bru->bru.blend_virtual = &bru->blend_virtual;
+static void *alloc_work_mem(
+	struct vspm_if_work_buff_t *work_buff,
+	unsigned int cls,
+	dma_addr_t *hard_addr)
+{
+	struct vspm_if_work_pool_t *pool = work_buff->pool;
+	struct vspm_if_work_mem_t *mem;
+	unsigned long lock_flag;
+
+	if (work_buff->num >= VSPM_IF_WORK_REGION_MAX)
+		return NULL;
+
+	/* borrow memory of the size class */
+	mem = get_work_mem(cls);
+	if (!mem)
+		return NULL;
+	work_buff->mem[work_buff->num++] = mem;
+
+	spin_lock_irqsave(&pool->lock, lock_flag);
+	pool->mem_used += work_mem_size[cls];
+	if (pool->mem_peak < pool->mem_used)
+		pool->mem_peak = pool->mem_used;
+	spin_unlock_irqrestore(&pool->lock, lock_flag);
+
+	*hard_addr = mem->hard_addr;
+	return mem->virt_addr;
+}
+
+static void free_work_mem(struct vspm_if_work_buff_t *work_buff)
+{
+	struct vspm_if_work_pool_t *pool = work_buff->pool;
+	struct vspm_if_work_mem_t *mem;
+	unsigned long lock_flag;
+	unsigned int size = 0;
+
+	/* return all memory of the job */
+	while (work_buff->num) {
+		mem = work_buff->mem[--work_buff->num];
+		size += work_mem_size[mem->cls];
+		put_work_mem(mem);
 	}
 
-	src_blend[0] = &bru->bru.blend_unit_a;
-	src_blend[1] = &bru->bru.blend_unit_b;
-	src_blend[2] = &bru->bru.blend_unit_c;
-	src_blend[3] = &bru->bru.blend_unit_d;
-	src_blend[4] = &bru->bru.blend_unit_e;
+	/* release referenced tables */
+	while (work_buff->tbl_ref_num)
+		put_tbl(work_buff->tbl_ref[--work_buff->tbl_ref_num]);
 
-	/* copy vsp_bld_ctrl_t parameter */
-	for (i = 0; i < 5; i++) {
-		if (*src_blend[i]) {
-			if (copy_from_user(
-					&bru->blend_unit[i],
-					(void __user *)*src_blend[i],
-					sizeof(struct vsp_bld_ctrl_t))) {
-				EPRINT(
-					"failed to copy of vsp_bld_ctrl_t\n");
-				return -EFAULT;
-			}
-			*src_blend[i] = &bru->blend_unit[i];
-		}
+	/* display list of configured size is kept */
+	if (work_buff->dl_used) {
+		work_buff->dl_used = 0;
+		size += work_buff->dl_size;
 	}
 
-	/* copy vsp_bld_rop_t parameter */
-	if (bru->bru.rop_unit) {
-		if (copy_from_user(
-				&bru->rop_unit,
-				(void __user *)bru->bru.rop_unit,
-				sizeof(struct vsp_bld_rop_t))) {
-			EPRINT("failed to copy of vsp_bld_rop_t\n");
-			return -EFAULT;
+	spin_lock_irqsave(&pool->lock, lock_flag);
+	pool->mem_used -= size;
+	spin_unlock_irqrestore(&pool->lock, lock_flag);
+}
+
+static void free_work_dl(struct vspm_if_work_buff_t *work_buff)
+{
+	if (work_buff->dl_virt_addr) {
+		dma_free_coherent(
+			&g_vspmif_pdev->dev,
+			work_buff->dl_size,
+			work_buff->dl_virt_addr,
+			work_buff->dl_hard_addr);
+		work_buff->dl_virt_addr = NULL;
+	}
+	work_buff->dl_size = 0;
+}
+
+static void take_work_buffer(
+	struct vspm_if_work_pool_t *pool, struct vspm_if_work_buff_t *work_buff)
+{
+	work_buff->use_flag = 1;
+	work_buff->num = 0;
+
+	pool->used++;
+	if (pool->peak < pool->used)
+		pool->peak = pool->used;
+}
+
+struct vspm_if_work_buff_t *get_work_buffer(struct vspm_if_private_t *priv)
+{
+	struct vspm_if_work_pool_t *pool = &priv->work_pool;
+	struct vspm_if_work_buff_t *cur_buff = NULL;
+
+	unsigned long lock_flag;
+
+	/* get unused work buffer */
+	spin_lock_irqsave(&pool->lock, lock_flag);
+	if (!list_empty(&pool->free)) {
+		cur_buff = list_first_entry(
+			&pool->free, struct vspm_if_work_buff_t, list);
+		list_del(&cur_buff->list);
+		take_work_buffer(pool, cur_buff);
+	}
+	spin_unlock_irqrestore(&pool->lock, lock_flag);
+
+	if (cur_buff)
+		return cur_buff;
+
+	/* allocate work buffer */
+	/* (memory is assigned for each use by alloc_work_mem) */
+	cur_buff = kzalloc(sizeof(struct vspm_if_work_buff_t), GFP_KERNEL);
+	if (!cur_buff) {
+		EPRINT("failed to allocate memory\n");
+		return NULL;
+	}
+	cur_buff->pool = pool;
+
+	/* connect work buffer */
+	down(&priv->sem);
+	cur_buff->next_buff = priv->work_buff;
+	priv->work_buff = cur_buff;
+	up(&priv->sem);
+
+	/* set work buffer */
+	spin_lock_irqsave(&pool->lock, lock_flag);
+	pool->num++;
+	take_work_buffer(pool, cur_buff);
+	spin_unlock_irqrestore(&pool->lock, lock_flag);
+
+	return cur_buff;
+}
+
+void put_work_buffer(struct vspm_if_work_buff_t *work_buff)
+{
+	struct vspm_if_work_pool_t *pool = work_buff->pool;
+	unsigned long lock_flag;
+
+	/* release memory */
+	free_work_mem(work_buff);
+
+	/* return to free list */
+	spin_lock_irqsave(&pool->lock, lock_flag);
+	if (work_buff->use_flag) {
+		work_buff->use_flag = 0;
+		list_add(&work_buff->list, &pool->free);
+		pool->used--;
+	}
+	spin_unlock_irqrestore(&pool->lock, lock_flag);
+}
+
+void release_work_buffers(struct vspm_if_private_t *priv)
+{
+	struct vspm_if_work_pool_t *pool = &priv->work_pool;
+	struct vspm_if_work_buff_t *cur_buff;
+	struct vspm_if_work_buff_t *next_buff;
+
+	unsigned long lock_flag;
+
+	down(&priv->sem);
+
+	cur_buff = priv->work_buff;
+	while (cur_buff) {
+		next_buff = cur_buff->next_buff;
+
+		/* release work buffer */
+		free_work_mem(cur_buff);
+		free_work_dl(cur_buff);
+		kfree(cur_buff);
+
+		cur_buff = next_buff;
+	}
+	priv->work_buff = NULL;
+
+	spin_lock_irqsave(&pool->lock, lock_flag);
+	INIT_LIST_HEAD(&pool->free);
+	pool->num = 0;
+	pool->used = 0;
+	spin_unlock_irqrestore(&pool->lock, lock_flag);
+
+	up(&priv->sem);
+
+	/* keep only prewarmed amount of memory */
+	trim_work_mem_cache();
+}
+
+static int set_vsp_hgo_buff(
+	struct vspm_entry_vsp_hgo *hgo, struct vspm_if_work_buff_t *work_buff)
+{
+	dma_addr_t hard_addr;
+
+	/* assign memory */
+	hgo->hgo.virt_addr =
+		alloc_work_mem(work_buff, VSPM_IF_MEM_HGO, &hard_addr);
+	if (!hgo->hgo.virt_addr)
+		return -ENOMEM;
+	hgo->hgo.hard_addr = VSPM_IF_DMA_TO_INT(hard_addr);
+
+	return 0;
+}
+
+static int set_vsp_hgt_buff(
+	struct vspm_entry_vsp_hgt *hgt, struct vspm_if_work_buff_t *work_buff)
+{
+	dma_addr_t hard_addr;
+
+	/* assign memory */
+	hgt->hgt.virt_addr =
+		alloc_work_mem(work_buff, VSPM_IF_MEM_HGT, &hard_addr);
+	if (!hgt->hgt.virt_addr)
+		return -ENOMEM;
+	hgt->hgt.hard_addr = VSPM_IF_DMA_TO_INT(hard_addr);
+
+	return 0;
+}
+
+static int set_vsp_dl_buff(struct vspm_entry_vsp *vsp)
+{
+	struct vsp_dl_t *dl_par = &vsp->par.dl_par;
+	struct vspm_if_work_buff_t *work_buff = vsp->work_buff;
+	struct vspm_if_work_pool_t *pool = work_buff->pool;
+	dma_addr_t hard_addr;
+
+	unsigned int dl_size = pool->dl_size;
+	unsigned long lock_flag;
+
+	if (!dl_size) {
+		/* assign memory for display list */
+		dl_par->virt_addr =
+			alloc_work_mem(work_buff, VSPM_IF_MEM_DL, &hard_addr);
+		if (!dl_par->virt_addr)
+			return -ENOMEM;
+		dl_par->hard_addr = VSPM_IF_DMA_TO_INT(hard_addr);
+		dl_par->tbl_num = VSPM_IF_DL_SIZE >> 3;
+
+		return 0;
+	}
+
+	/* display list of configured size is kept by the work buffer */
+	if (work_buff->dl_size != dl_size) {
+		free_work_dl(work_buff);
+		work_buff->dl_virt_addr = dma_alloc_coherent(
+			&g_vspmif_pdev->dev,
+			dl_size,
+			&work_buff->dl_hard_addr,
+			GFP_KERNEL);
+		if (!work_buff->dl_virt_addr) {
+			EPRINT("failed to allocate display list\n");
+			return -ENOMEM;
 		}
-		bru->bru.rop_unit = &bru->rop_unit;
+		work_buff->dl_size = dl_size;
 	}
+	work_buff->dl_used = 1;
+
+	spin_lock_irqsave(&pool->lock, lock_flag);
+	pool->mem_used += dl_size;
+	if (pool->mem_peak < pool->mem_used)
+		pool->mem_peak = pool->mem_used;
+	spin_unlock_irqrestore(&pool->lock, lock_flag);
+
+	dl_par->virt_addr = work_buff->dl_virt_addr;
+	dl_par->hard_addr = VSPM_IF_DMA_TO_INT(work_buff->dl_hard_addr);
+	dl_par->tbl_num = dl_size >> 3;
 
 	return 0;
 }
 
-static int set_vsp_hgo_par(
-	struct vspm_entry_vsp_hgo *hgo,
-	struct vsp_hgo_t *src,
+static int set_cached_tbl_par(
+	struct vsp_dl_t *dl,
+	unsigned int id,
+	unsigned int tbl_num_max,
 	struct vspm_if_work_buff_t *work_buff)
 {
-	unsigned long tmp_addr;
+	struct vspm_if_private_t *priv = container_of(
+		work_buff->pool, struct vspm_if_private_t, work_pool);
+	struct vspm_if_tbl_t *cached;
 
-	/* copy vsp_hgo_t parameter */
-	if (copy_from_user(
-			&hgo->hgo,
-			(void __user *)src,
-			sizeof(struct vsp_hgo_t))) {
-		EPRINT("failed to copy of vsp_hgo_t\n");
-		return -EFAULT;
-	}
-	hgo->user_addr = hgo->hgo.virt_addr;
+	if (work_buff->tbl_ref_num >= VSPM_IF_WORK_TBL_MAX)
+		return -EINVAL;
+
+	/* find registered table */
+	mutex_lock(&priv->tbl_lock);
+	cached = idr_find(&priv->tbl_idr, id);
+	if (cached)
+		kref_get(&cached->ref);
+	mutex_unlock(&priv->tbl_lock);
+	if (!cached)
+		return -ENOENT;
+
+	/* the job keeps the table until it is done */
+	work_buff->tbl_ref[work_buff->tbl_ref_num++] = cached;
+
+	if (cached->tbl_num > tbl_num_max)
+		return -EINVAL;
 
 	/* set parameter */
-	tmp_addr =
-		(unsigned long)work_buff->hard_addr +
-		(unsigned long)work_buff->offset;
-	hgo->hgo.hard_addr = (unsigned int)tmp_addr;
-	tmp_addr =
-		(unsigned long)work_buff->virt_addr +
-		(unsigned long)work_buff->offset;
-	hgo->hgo.virt_addr = (void *)tmp_addr;
-
-	/* increment memory offset */
-	work_buff->offset += VSPM_IF_HGO_SIZE;
+	dl->virt_addr = cached->virt_addr;
+	dl->hard_addr = VSPM_IF_DMA_TO_INT(cached->hard_addr);
+	dl->tbl_num = cached->tbl_num;
 
 	return 0;
 }
 
-static int set_vsp_hgt_par(
-	struct vspm_entry_vsp_hgt *hgt,
-	struct vsp_hgt_t *src,
+static int set_vsp_tbl_par(
+	struct vsp_dl_t *dl, struct vspm_if_work_buff_t *work_buff)
+{
+	/* table of user space is used as it is */
+	if (dl->virt_addr || dl->tbl_num != VSPM_IF_TBL_CACHED)
+		return 0;
+
+	/* use registered table */
+	return set_cached_tbl_par(
+		dl, dl->hard_addr, VSPM_IF_TBL_NUM_MAX, work_buff);
+}
+
+static int set_vsp_src_clut_par(
+	struct vsp_dl_t *clut,
+	struct vsp_dl_t *src,
 	struct vspm_if_work_buff_t *work_buff)
 {
-	unsigned long tmp_addr;
+	dma_addr_t hard_addr;
+	void *virt_addr;
 
-	/* copy vsp_hgt_t parameter */
+	/* copy vsp_dl_t parameter */
 	if (copy_from_user(
-			&hgt->hgt,
+			clut,
 			(void __user *)src,
-			sizeof(struct vsp_hgt_t))) {
-		EPRINT("failed to copy of vsp_hgt_t\n");
+			sizeof(struct vsp_dl_t))) {
+		EPRINT("failed to copy of vsp_dl_t\n");
 		return -EFAULT;
 	}
-	hgt->user_addr = hgt->hgt.virt_addr;
 
-	/* set parameter */
-	tmp_addr =
-		(unsigned long)work_buff->hard_addr +
-		(unsigned long)work_buff->offset;
-	hgt->hgt.hard_addr = (unsigned int)tmp_addr;
-	tmp_addr =
-		(unsigned long)work_buff->virt_addr +
-		(unsigned long)work_buff->offset;
-	hgt->hgt.virt_addr = (void *)tmp_addr;
-
-	/* increment memory offset */
-	work_buff->offset += VSPM_IF_HGT_SIZE;
+	/* use registered color table */
+	if (!clut->virt_addr && clut->tbl_num == VSPM_IF_TBL_CACHED) {
+		return set_cached_tbl_par(
+			clut,
+			clut->hard_addr,
+			VSPM_IF_CLUT_TBL_NUM_MAX,
+			work_buff);
+	}
+
+	if (clut->virt_addr &&
+	    clut->tbl_num > 0 &&
+	    clut->tbl_num <= 256) {
+		/* assign memory */
+		virt_addr = alloc_work_mem(
+			work_buff, VSPM_IF_MEM_CLUT, &hard_addr);
+		if (!virt_addr)
+			return -ENOMEM;
+
+		/* copy color table */
+		if (copy_from_user(
+				virt_addr,
+				(void __user *)clut->virt_addr,
+				clut->tbl_num * 8)) {
+			EPRINT("failed to copy of color table\n");
+			return -EFAULT;
+		}
+
+		/* set parameter */
+		clut->virt_addr = virt_addr;
+		clut->hard_addr = VSPM_IF_DMA_TO_INT(hard_addr);
+	}
 
 	return 0;
 }
 
-static int set_vsp_ctrl_par(
-	struct vspm_entry_vsp_ctrl *ctrl,
-	struct vsp_ctrl_t *src,
-	struct vspm_if_work_buff_t *work_buff)
+static int set_vsp_src_alpha_par(
+	struct vspm_entry_vsp_in_alpha *alpha, struct vsp_alpha_unit_t *src)
 {
-	int ercd;
-
-	/* copy vsp_ctrl_t parameter */
+	/* copy vsp_alpha_unit_t parameter */
 	if (copy_from_user(
-			&ctrl->ctrl,
+			&alpha->alpha,
 			(void __user *)src,
-			sizeof(struct vsp_ctrl_t))) {
-		EPRINT("failed to copy of vsp_ctrl_t\n");
+			sizeof(struct vsp_alpha_unit_t))) {
+		EPRINT("failed to copy of vsp_alpha_unit_t\n");
 		return -EFAULT;
 	}
 
-	/* copy vsp_sru_t parameter */
-	if (ctrl->ctrl.sru) {
+	/* copy vsp_irop_unit_t paramerter */
+	if (alpha->alpha.irop) {
 		if (copy_from_user(
-				&ctrl->sru,
-				(void __user *)ctrl->ctrl.sru,
-				sizeof(struct vsp_sru_t))) {
-			EPRINT("failed to copy of vsp_sru_t\n");
+				&alpha->irop,
+				(void __user *)alpha->alpha.irop,
+				sizeof(struct vsp_irop_unit_t))) {
+			EPRINT("failed to copy of vsp_irop_unit_t\n");
 			return -EFAULT;
 		}
-		ctrl->ctrl.sru = &ctrl->sru;
+		alpha->alpha.irop = &alpha->irop;
 	}
 
-	/* copy vsp_uds_t parameter */
-	if (ctrl->ctrl.uds) {
+	/* copy vsp_ckey_unit_t paramerter */
+	if (alpha->alpha.ckey) {
 		if (copy_from_user(
-				&ctrl->uds,
-				(void __user *)ctrl->ctrl.uds,
-				sizeof(struct vsp_uds_t))) {
-			EPRINT("failed to copy of vsp_uds_t\n");
+				&alpha->ckey,
+				(void __user *)alpha->alpha.ckey,
+				sizeof(struct vsp_ckey_unit_t))) {
+			EPRINT("failed to copy of vsp_ckey_unit_t\n");
 			return -EFAULT;
 		}
-		ctrl->ctrl.uds = &ctrl->uds;
+		alpha->alpha.ckey = &alpha->ckey;
 	}
 
-	/* copy vsp_lut_t parameter */
-	if (ctrl->ctrl.lut) {
+	/* copy vsp_mult_unit_t paramerter */
+	if (alpha->alpha.mult) {
 		if (copy_from_user(
-				&ctrl->lut,
-				(void __user *)ctrl->ctrl.lut,
-				sizeof(struct vsp_lut_t))) {
-			EPRINT("failed to copy of vsp_lut_t\n");
+				&alpha->mult,
+				(void __user *)alpha->alpha.mult,
+				sizeof(struct vsp_mult_unit_t))) {
+			EPRINT("failed to copy of vsp_mult_unit_t\n");
 			return -EFAULT;
 		}
-		ctrl->ctrl.lut = &ctrl->lut;
+		alpha->alpha.mult = &alpha->mult;
 	}
 
-	/* copy vsp_clu_t parameter */
-	if (ctrl->ctrl.clu) {
-		if (copy_from_user(
-				&ctrl->clu,
+	return 0;
+}
+
+static int set_vsp_src_par(
+	struct vspm_entry_vsp_in *in,
+	struct vsp_src_t *src,
+	struct vspm_if_work_buff_t *work_buff)
+{
+	int ercd;
+
+	/* copy vsp_src_t parameter */
+	if (copy_from_user(
+			&in->in,
+			(void __user *)src,
+			sizeof(struct vsp_src_t))) {
+		EPRINT("failed to copy of vsp_src_t\n");
+		return -EFAULT;
+	}
+
+	/* copy vsp_dl_t parameter */
+	if (in->in.clut) {
+		ercd = set_vsp_src_clut_par(&in->clut, in->in.clut, work_buff);
+		if (ercd)
+			return ercd;
+		in->in.clut = &in->clut;
+	}
+
+	/* copy vsp_alpha_unit_t parameter */
+	if (in->in.alpha) {
+		ercd = set_vsp_src_alpha_par(&in->alpha, in->in.alpha);
+		if (ercd)
+			return ercd;
+		in->in.alpha = &in->alpha.alpha;
+	}
+
+	return 0;
+}
+
+static int set_vsp_dst_par(
+	struct vspm_entry_vsp_out *out, struct vsp_dst_t *src)
+{
+	/* copy vsp_dst_t parameter */
+	if (copy_from_user(
+			&out->out,
+			(void __user *)src,
+			sizeof(struct vsp_dst_t))) {
+		EPRINT("failed to copy of vsp_dst_t\n");
+		return -EFAULT;
+	}
+
+	/* copy fcp_info_t parameter */
+	if (out->out.fcp) {
+		if (copy_from_user(
+				&out->fcp,
+				(void __user *)out->out.fcp,
+				sizeof(struct fcp_info_t))) {
+			EPRINT("failed to copy of fcp_info_t\n");
+			return -EFAULT;
+		}
+		out->out.fcp = &out->fcp;
+	}
+
+	return 0;
+}
+
+static int set_vsp_bru_par(
+	struct vspm_entry_vsp_bru *bru, struct vsp_bru_t *src)
+{
+	struct vsp_bld_ctrl_t **src_blend[5];
+	int i;
+
+	/* copy vsp_bru_t parameter */
+	if (copy_from_user(
+			&bru->bru,
+			(void __user *)src,
+			sizeof(struct vsp_bru_t))) {
+		EPRINT("failed to copy of vsp_bru_t\n");
+		return -EFAULT;
+	}
+
+	/* copy vsp_bld_dither_t parameter */
+	for (i = 0; i < 5; i++) {
+		if (bru->bru.dither_unit[i]) {
+			if (copy_from_user(
+					&bru->dither_unit[i],
+					(void __user *)bru->bru.dither_unit[i],
+					sizeof(struct vsp_bld_dither_t))) {
+				EPRINT("failed to copy of vsp_bld_dither_t\n");
+				return -EFAULT;
+			}
+			bru->bru.dither_unit[i] = &bru->dither_unit[i];
+		}
+	}
+
+	/* copy vsp_bld_vir_t parameter */
+	if (bru->bru.blend_virtual) {
+		if (copy_from_user(
+				&bru->blend_virtual,
+				(void __user *)bru->bru.blend_virtual,
+				sizeof(struct vsp_bld_vir_t))) {
+			EPRINT("failed to copy of vsp_bld_vir_t\n");
+			return -EFAULT;
+		}
+		bru->bru.blend_virtual = &bru->blend_virtual;
+	}
+
+	src_blend[0] = &bru->bru.blend_unit_a;
+	src_blend[1] = &bru->bru.blend_unit_b;
+	src_blend[2] = &bru->bru.blend_unit_c;
+	src_blend[3] = &bru->bru.blend_unit_d;
+	src_blend[4] = &bru->bru.blend_unit_e;
+
+	/* copy vsp_bld_ctrl_t parameter */
+	for (i = 0; i < 5; i++) {
+		if (*src_blend[i]) {
+			if (copy_from_user(
+					&bru->blend_unit[i],
+					(void __user *)*src_blend[i],
+					sizeof(struct vsp_bld_ctrl_t))) {
+				EPRINT(
+					"failed to copy of vsp_bld_ctrl_t\n");
+				return -EFAULT;
+			}
+			*src_blend[i] = &bru->blend_unit[i];
+		}
+	}
+
+	/* copy vsp_bld_rop_t parameter */
+	if (bru->bru.rop_unit) {
+		if (copy_from_user(
+				&bru->rop_unit,
+				(void __user *)bru->bru.rop_unit,
+				sizeof(struct vsp_bld_rop_t))) {
+			EPRINT("failed to copy of vsp_bld_rop_t\n");
+			return -EFAULT;
+		}
+		bru->bru.rop_unit = &bru->rop_unit;
+	}
+
+	return 0;
+}
+
+static int set_vsp_hgo_par(
+	struct vspm_entry_vsp_hgo *hgo,
+	struct vsp_hgo_t *src,
+	struct vspm_if_work_buff_t *work_buff)
+{
+	/* copy vsp_hgo_t parameter */
+	if (copy_from_user(
+			&hgo->hgo,
+			(void __user *)src,
+			sizeof(struct vsp_hgo_t))) {
+		EPRINT("failed to copy of vsp_hgo_t\n");
+		return -EFAULT;
+	}
+	hgo->user_addr = hgo->hgo.virt_addr;
+
+	/* assign memory for histogram */
+	return set_vsp_hgo_buff(hgo, work_buff);
+}
+
+static int set_vsp_hgt_par(
+	struct vspm_entry_vsp_hgt *hgt,
+	struct vsp_hgt_t *src,
+	struct vspm_if_work_buff_t *work_buff)
+{
+	/* copy vsp_hgt_t parameter */
+	if (copy_from_user(
+			&hgt->hgt,
+			(void __user *)src,
+			sizeof(struct vsp_hgt_t))) {
+		EPRINT("failed to copy of vsp_hgt_t\n");
+		return -EFAULT;
+	}
+	hgt->user_addr = hgt->hgt.virt_addr;
+
+	/* assign memory for histogram */
+	return set_vsp_hgt_buff(hgt, work_buff);
+}
+
+static int set_vsp_ctrl_par(
+	struct vspm_entry_vsp_ctrl *ctrl,
+	struct vsp_ctrl_t *src,
+	struct vspm_if_work_buff_t *work_buff)
+{
+	int ercd;
+
+	/* copy vsp_ctrl_t parameter */
+	if (copy_from_user(
+			&ctrl->ctrl,
+			(void __user *)src,
+			sizeof(struct vsp_ctrl_t))) {
+		EPRINT("failed to copy of vsp_ctrl_t\n");
+		return -EFAULT;
+	}
+
+	/* copy vsp_sru_t parameter */
+	if (ctrl->ctrl.sru) {
+		if (copy_from_user(
+				&ctrl->sru,
+				(void __user *)ctrl->ctrl.sru,
+				sizeof(struct vsp_sru_t))) {
+			EPRINT("failed to copy of vsp_sru_t\n");
+			return -EFAULT;
+		}
+		ctrl->ctrl.sru = &ctrl->sru;
+	}
+
+	/* copy vsp_uds_t parameter */
+	if (ctrl->ctrl.uds) {
+		if (copy_from_user(
+				&ctrl->uds,
+				(void __user *)ctrl->ctrl.uds,
+				sizeof(struct vsp_uds_t))) {
+			EPRINT("failed to copy of vsp_uds_t\n");
+			return -EFAULT;
+		}
+		ctrl->ctrl.uds = &ctrl->uds;
+	}
+
+	/* copy vsp_lut_t parameter */
+	if (ctrl->ctrl.lut) {
+		if (copy_from_user(
+				&ctrl->lut,
+				(void __user *)ctrl->ctrl.lut,
+				sizeof(struct vsp_lut_t))) {
+			EPRINT("failed to copy of vsp_lut_t\n");
+			return -EFAULT;
+		}
+		ercd = set_vsp_tbl_par(&ctrl->lut.lut, work_buff);
+		if (ercd)
+			return ercd;
+		ctrl->ctrl.lut = &ctrl->lut;
+	}
+
+	/* copy vsp_clu_t parameter */
+	if (ctrl->ctrl.clu) {
+		if (copy_from_user(
+				&ctrl->clu,
 				(void __user *)ctrl->ctrl.clu,
 				sizeof(struct vsp_clu_t))) {
 			EPRINT("failed to copy of vsp_clu_t\n");
 			return -EFAULT;
 		}
+		ercd = set_vsp_tbl_par(&ctrl->clu.clu, work_buff);
+		if (ercd)
+			return ercd;
 		ctrl->ctrl.clu = &ctrl->clu;
 	}
 
@@ -613,8 +1317,10 @@ static int set_vsp_ctrl_par(
 
 int free_vsp_par(struct vspm_entry_vsp *vsp)
 {
-	if (vsp->work_buff)
-		vsp->work_buff->use_flag = 0;
+	if (vsp->work_buff) {
+		put_work_buffer(vsp->work_buff);
+		vsp->work_buff = NULL;
+	}
 
 	return 0;
 }
@@ -624,9 +1330,6 @@ int set_vsp_par(
 {
 	struct vspm_entry_vsp *vsp = &entry->ip_par.vsp;
 
-	struct vsp_dl_t *dl_par = &vsp->par.dl_par;
-	unsigned long tmp_addr;
-
 	int ercd = 0;
 
 	int i;
@@ -676,15 +1379,9 @@ int set_vsp_par(
 	}
 
 	/* assign memory for display list */
-	tmp_addr =
-		(unsigned long)vsp->work_buff->hard_addr +
-		(unsigned long)vsp->work_buff->offset;
-	dl_par->hard_addr = (unsigned int)tmp_addr;
-	tmp_addr =
-		(unsigned long)vsp->work_buff->virt_addr +
-		(unsigned long)vsp->work_buff->offset;
-	dl_par->virt_addr = (void *)tmp_addr;
-	dl_par->tbl_num = (VSPM_IF_MEM_SIZE - vsp->work_buff->offset) >> 3;
+	ercd = set_vsp_dl_buff(vsp);
+	if (ercd)
+		goto err_exit;
 
 	return 0;
 
@@ -695,12 +1392,23 @@ err_exit:
 
 int free_cb_vsp_par(struct vspm_if_cb_data_t *cb_data)
 {
-	if (cb_data->vsp_work_buff)
-		cb_data->vsp_work_buff->use_flag = 0;
+	if (cb_data->vsp_work_buff) {
+		put_work_buffer(cb_data->vsp_work_buff);
+		cb_data->vsp_work_buff = NULL;
+	}
 
 	return 0;
 }
 
+void free_cb_data(struct vspm_if_cb_data_t *cb_data)
+{
+	struct vspm_if_entry_data_t *entry_data =
+		container_of(cb_data, struct vspm_if_entry_data_t, cb_data);
+
+	free_cb_vsp_par(cb_data);
+	put_entry_data(entry_data);
+}
+
 void set_cb_rsp_vsp(
 	struct vspm_if_cb_data_t *cb_data,
 	struct vspm_if_entry_data_t *entry_data)
@@ -851,1023 +1559,2241 @@ int set_fdp_par(
 		ercd = set_fdp_fproc_par(&fdp->fproc, fdp->par.fproc_par);
 		if (ercd)
 			return ercd;
-		fdp->par.fproc_par = &fdp->fproc.fproc;
+		fdp->par.fproc_par = &fdp->fproc.fproc;
+	}
+
+	return 0;
+}
+
+static int copy_compat_par(
+	const struct vspm_if_par_src_t *psrc,
+	void *dst,
+	unsigned int src,
+	unsigned long size)
+{
+	/* copy from flat descriptor */
+	if (psrc) {
+		if (src > psrc->size || size > psrc->size - src)
+			return -EFAULT;
+		memcpy(dst, (const char *)psrc->desc + src, size);
+		return 0;
+	}
+
+	/* copy from user space */
+	if (copy_from_user(dst, VSPM_IF_INT_TO_UP(src), size))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int set_compat_vsp_src_clut_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vsp_dl_t *clut,
+	unsigned int src,
+	struct vspm_if_work_buff_t *work_buff)
+{
+	struct compat_vsp_dl_t compat_dl_par;
+	dma_addr_t hard_addr;
+	void *virt_addr;
+
+	/* copy */
+	if (copy_compat_par(
+			psrc,
+			&compat_dl_par,
+			src,
+			sizeof(struct compat_vsp_dl_t))) {
+		EPRINT("failed to copy of vsp_dl_t\n");
+		return -EFAULT;
+	}
+
+	/* use registered color table */
+	if (compat_dl_par.virt_addr == 0 &&
+	    compat_dl_par.tbl_num == VSPM_IF_TBL_CACHED) {
+		return set_cached_tbl_par(
+			clut,
+			compat_dl_par.hard_addr,
+			VSPM_IF_CLUT_TBL_NUM_MAX,
+			work_buff);
+	}
+
+	if (compat_dl_par.virt_addr != 0 &&
+	    compat_dl_par.tbl_num > 0 &&
+	    compat_dl_par.tbl_num <= 256) {
+		/* assign memory */
+		virt_addr = alloc_work_mem(
+			work_buff, VSPM_IF_MEM_CLUT, &hard_addr);
+		if (!virt_addr)
+			return -ENOMEM;
+
+		/* copy color table */
+		if (copy_compat_par(
+				psrc,
+				virt_addr,
+				compat_dl_par.virt_addr,
+				compat_dl_par.tbl_num * 8)) {
+			EPRINT("failed to copy color table\n");
+			return -EFAULT;
+		}
+
+		/* set parameter */
+		clut->virt_addr = virt_addr;
+		clut->hard_addr = VSPM_IF_DMA_TO_INT(hard_addr);
+		clut->tbl_num = compat_dl_par.tbl_num;
+	}
+
+	return 0;
+}
+
+static int set_compat_vsp_irop_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vsp_irop_unit_t *irop,
+	unsigned int src)
+{
+	struct compat_vsp_irop_unit_t compat_irop;
+
+	/* copy */
+	if (copy_compat_par(
+			psrc,
+			&compat_irop,
+			src,
+			sizeof(struct compat_vsp_irop_unit_t))) {
+		EPRINT("failed to copy of vsp_irop_unit_t\n");
+		return -EFAULT;
+	}
+
+	/* set */
+	irop->op_mode = compat_irop.op_mode;
+	irop->ref_sel = compat_irop.ref_sel;
+	irop->bit_sel = compat_irop.bit_sel;
+	irop->comp_color = (unsigned long)compat_irop.comp_color;
+	irop->irop_color0 = (unsigned long)compat_irop.irop_color0;
+	irop->irop_color1 = (unsigned long)compat_irop.irop_color1;
+
+	return 0;
+}
+
+static int set_compat_vsp_ckey_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vsp_ckey_unit_t *ckey,
+	unsigned int src)
+{
+	struct compat_vsp_ckey_unit_t compat_ckey;
+
+	/* copy */
+	if (copy_compat_par(
+			psrc,
+			&compat_ckey,
+			src,
+			sizeof(struct compat_vsp_ckey_unit_t))) {
+		EPRINT("failed to copy of vsp_ckey_unit_t\n");
+		return -EFAULT;
+	}
+
+	/* set */
+	ckey->mode = compat_ckey.mode;
+	ckey->color1 = (unsigned long)compat_ckey.color1;
+	ckey->color2 = (unsigned long)compat_ckey.color2;
+
+	return 0;
+}
+
+static int set_compat_vsp_src_alpha_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_entry_vsp_in_alpha *alpha,
+	unsigned int src)
+{
+	struct compat_vsp_alpha_unit_t compat_alpha;
+	int ercd;
+
+	/* copy vsp_alpha_unit_t parameter */
+	if (copy_compat_par(
+			psrc,
+			&compat_alpha,
+			src,
+			sizeof(struct compat_vsp_alpha_unit_t))) {
+		EPRINT("failed to copy of vsp_alpha_unit_t\n");
+		return -EFAULT;
+	}
+
+	alpha->alpha.addr_a = compat_alpha.addr_a;
+	alpha->alpha.stride_a = compat_alpha.stride_a;
+	alpha->alpha.swap = compat_alpha.swap;
+	alpha->alpha.asel = compat_alpha.asel;
+	alpha->alpha.aext = compat_alpha.aext;
+	alpha->alpha.anum0 = compat_alpha.anum0;
+	alpha->alpha.anum1 = compat_alpha.anum1;
+	alpha->alpha.afix = compat_alpha.afix;
+
+	/* copy vsp_irop_unit_t paramerter */
+	if (compat_alpha.irop) {
+		ercd = set_compat_vsp_irop_par(
+			psrc, &alpha->irop, compat_alpha.irop);
+		if (ercd)
+			return ercd;
+		alpha->alpha.irop = &alpha->irop;
+	}
+
+	/* copy vsp_ckey_unit_t paramerter */
+	if (compat_alpha.ckey) {
+		ercd = set_compat_vsp_ckey_par(
+			psrc, &alpha->ckey, compat_alpha.ckey);
+		if (ercd)
+			return ercd;
+		alpha->alpha.ckey = &alpha->ckey;
+	}
+
+	/* copy vsp_mult_unit_t paramerter */
+	if (compat_alpha.mult) {
+		if (copy_compat_par(
+				psrc,
+				&alpha->mult,
+				compat_alpha.mult,
+				sizeof(struct vsp_mult_unit_t))) {
+			EPRINT("failed to copy of vsp_mult_unit_t\n");
+			return -EFAULT;
+		}
+		alpha->alpha.mult = &alpha->mult;
+	}
+
+	return 0;
+}
+
+static int set_compat_vsp_src_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_entry_vsp_in *in,
+	unsigned int src,
+	struct vspm_if_work_buff_t *work_buff)
+{
+	struct compat_vsp_src_t compat_vsp_src;
+	int ercd;
+
+	/* copy vsp_src_t parameter */
+	if (copy_compat_par(
+			psrc,
+			&compat_vsp_src,
+			src,
+			sizeof(struct compat_vsp_src_t))) {
+		EPRINT("failed to copy of vsp_src_t\n");
+		return -EFAULT;
+	}
+
+	in->in.addr = compat_vsp_src.addr;
+	in->in.addr_c0 = compat_vsp_src.addr_c0;
+	in->in.addr_c1 = compat_vsp_src.addr_c1;
+	in->in.stride = compat_vsp_src.stride;
+	in->in.stride_c = compat_vsp_src.stride_c;
+	in->in.width = compat_vsp_src.width;
+	in->in.height = compat_vsp_src.height;
+	in->in.width_ex = compat_vsp_src.width_ex;
+	in->in.height_ex = compat_vsp_src.height_ex;
+	in->in.x_offset = compat_vsp_src.x_offset;
+	in->in.y_offset = compat_vsp_src.y_offset;
+	in->in.format = compat_vsp_src.format;
+	in->in.swap = compat_vsp_src.swap;
+	in->in.x_position = compat_vsp_src.x_position;
+	in->in.y_position = compat_vsp_src.y_position;
+	in->in.pwd = compat_vsp_src.pwd;
+	in->in.cipm = compat_vsp_src.cipm;
+	in->in.cext = compat_vsp_src.cext;
+	in->in.csc = compat_vsp_src.csc;
+	in->in.iturbt = compat_vsp_src.iturbt;
+	in->in.clrcng = compat_vsp_src.clrcng;
+	in->in.vir = compat_vsp_src.vir;
+	in->in.vircolor = (unsigned long)compat_vsp_src.vircolor;
+	in->in.connect = (unsigned long)compat_vsp_src.connect;
+
+	/* copy vsp_dl_t parameter */
+	if (compat_vsp_src.clut) {
+		ercd = set_compat_vsp_src_clut_par(
+			psrc, &in->clut, compat_vsp_src.clut, work_buff);
+		if (ercd)
+			return ercd;
+		in->in.clut = &in->clut;
+	}
+
+	/* copy vsp_alpha_unit_t parameter */
+	if (compat_vsp_src.alpha) {
+		ercd = set_compat_vsp_src_alpha_par(
+			psrc, &in->alpha, compat_vsp_src.alpha);
+		if (ercd)
+			return ercd;
+		in->in.alpha = &in->alpha.alpha;
+	}
+
+	return 0;
+}
+
+static int set_compat_vsp_dst_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_entry_vsp_out *out,
+	unsigned int src)
+{
+	struct compat_vsp_dst_t compat_vsp_dst;
+
+	/* copy vsp_dst_t parameter */
+	if (copy_compat_par(
+			psrc,
+			&compat_vsp_dst,
+			src,
+			sizeof(struct compat_vsp_dst_t))) {
+		EPRINT("failed to copy of vsp_dst_t\n");
+		return -EFAULT;
+	}
+
+	out->out.addr = compat_vsp_dst.addr;
+	out->out.addr_c0 = compat_vsp_dst.addr_c0;
+	out->out.addr_c1 = compat_vsp_dst.addr_c1;
+	out->out.stride = compat_vsp_dst.stride;
+	out->out.stride_c = compat_vsp_dst.stride_c;
+	out->out.width = compat_vsp_dst.width;
+	out->out.height = compat_vsp_dst.height;
+	out->out.x_offset = compat_vsp_dst.x_offset;
+	out->out.y_offset = compat_vsp_dst.y_offset;
+	out->out.format = compat_vsp_dst.format;
+	out->out.swap = compat_vsp_dst.swap;
+	out->out.pxa = compat_vsp_dst.pxa;
+	out->out.pad = compat_vsp_dst.pad;
+	out->out.x_coffset = compat_vsp_dst.x_coffset;
+	out->out.y_coffset = compat_vsp_dst.y_coffset;
+	out->out.csc = compat_vsp_dst.csc;
+	out->out.iturbt = compat_vsp_dst.iturbt;
+	out->out.clrcng = compat_vsp_dst.clrcng;
+	out->out.cbrm = compat_vsp_dst.cbrm;
+	out->out.abrm = compat_vsp_dst.abrm;
+	out->out.athres = compat_vsp_dst.athres;
+	out->out.clmd = compat_vsp_dst.clmd;
+	out->out.dith = compat_vsp_dst.dith;
+	out->out.rotation = compat_vsp_dst.rotation;
+
+	/* copy fcp_info_t parameter */
+	if (compat_vsp_dst.fcp) {
+		if (copy_compat_par(
+				psrc,
+				&out->fcp,
+				compat_vsp_dst.fcp,
+				sizeof(struct fcp_info_t))) {
+			EPRINT("failed to copy to fcp_info_t\n");
+			return -EFAULT;
+		}
+		out->out.fcp = &out->fcp;
+	}
+
+	return 0;
+}
+
+static int set_compat_vsp_sru_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vsp_sru_t *sru,
+	unsigned int src)
+{
+	struct compat_vsp_sru_t compat_sru;
+
+	/* copy */
+	if (copy_compat_par(
+			psrc,
+			&compat_sru,
+			src,
+			sizeof(struct compat_vsp_sru_t))) {
+		EPRINT("failed to copy of vsp_sru_t\n");
+		return -EFAULT;
+	}
+
+	/* set */
+	sru->mode = compat_sru.mode;
+	sru->param = compat_sru.param;
+	sru->enscl = compat_sru.enscl;
+	sru->fxa = compat_sru.fxa;
+	sru->connect = (unsigned long)compat_sru.connect;
+
+	return 0;
+}
+
+static int set_compat_vsp_uds_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vsp_uds_t *uds,
+	unsigned int src)
+{
+	struct compat_vsp_uds_t compat_uds;
+
+	/* copy */
+	if (copy_compat_par(
+			psrc,
+			&compat_uds,
+			src,
+			sizeof(struct compat_vsp_uds_t))) {
+		EPRINT("failed to copy of vsp_uds_t\n");
+		return -EFAULT;
+	}
+
+	/* set */
+	uds->amd = compat_uds.amd;
+	uds->clip = compat_uds.clip;
+	uds->alpha = compat_uds.alpha;
+	uds->complement = compat_uds.complement;
+	uds->athres0 = compat_uds.athres0;
+	uds->athres1 = compat_uds.athres1;
+	uds->anum0 = compat_uds.anum0;
+	uds->anum1 = compat_uds.anum1;
+	uds->anum2 = compat_uds.anum2;
+	uds->x_ratio = compat_uds.x_ratio;
+	uds->y_ratio = compat_uds.y_ratio;
+	uds->connect = (unsigned long)compat_uds.connect;
+
+	return 0;
+}
+
+static int set_compat_vsp_lut_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vsp_lut_t *lut,
+	unsigned int src)
+{
+	struct compat_vsp_lut_t compat_lut;
+
+	/* copy */
+	if (copy_compat_par(
+			psrc,
+			&compat_lut,
+			src,
+			sizeof(struct compat_vsp_lut_t))) {
+		EPRINT("failed to copy of vsp_lut_t\n");
+		return -EFAULT;
+	}
+
+	/* set */
+	lut->lut.hard_addr = compat_lut.lut.hard_addr;
+	lut->lut.virt_addr = VSPM_IF_INT_TO_VP(compat_lut.lut.virt_addr);
+	lut->lut.tbl_num = compat_lut.lut.tbl_num;
+	lut->fxa = compat_lut.fxa;
+	lut->connect = (unsigned long)compat_lut.connect;
+
+	return 0;
+}
+
+static int set_compat_vsp_clu_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vsp_clu_t *clu,
+	unsigned int src)
+{
+	struct compat_vsp_clu_t compat_clu;
+
+	/* copy */
+	if (copy_compat_par(
+			psrc,
+			&compat_clu,
+			src,
+			sizeof(struct compat_vsp_clu_t))) {
+		EPRINT("failed to copy of vsp_clu_t\n");
+		return -EFAULT;
+	}
+
+	/* set */
+	clu->mode = compat_clu.mode;
+	clu->clu.hard_addr = compat_clu.clu.hard_addr;
+	clu->clu.virt_addr = VSPM_IF_INT_TO_VP(compat_clu.clu.virt_addr);
+	clu->clu.tbl_num = compat_clu.clu.tbl_num;
+	clu->fxa = compat_clu.fxa;
+	clu->connect = (unsigned long)compat_clu.connect;
+
+	return 0;
+}
+
+static int set_compat_vsp_hst_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vsp_hst_t *hst,
+	unsigned int src)
+{
+	struct compat_vsp_hst_t compat_hst;
+
+	/* copy */
+	if (copy_compat_par(
+			psrc,
+			&compat_hst,
+			src,
+			sizeof(struct compat_vsp_hst_t))) {
+		EPRINT("failed to copy of vsp_hst_t\n");
+		return -EFAULT;
+	}
+
+	/* set */
+	hst->fxa = compat_hst.fxa;
+	hst->connect = (unsigned long)compat_hst.connect;
+
+	return 0;
+}
+
+static int set_compat_vsp_hsi_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vsp_hsi_t *hsi,
+	unsigned int src)
+{
+	struct compat_vsp_hsi_t compat_hsi;
+
+	/* copy */
+	if (copy_compat_par(
+			psrc,
+			&compat_hsi,
+			src,
+			sizeof(struct compat_vsp_hsi_t))) {
+		EPRINT("failed to copy of vsp_hsi_t\n");
+		return -EFAULT;
+	}
+
+	/* set */
+	hsi->fxa = compat_hsi.fxa;
+	hsi->connect = (unsigned long)compat_hsi.connect;
+
+	return 0;
+}
+
+static int set_compat_vsp_bru_vir_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vsp_bld_vir_t *vir,
+	unsigned int src)
+{
+	struct compat_vsp_bld_vir_t compat_vir;
+
+	/* copy */
+	if (copy_compat_par(
+			psrc,
+			&compat_vir,
+			src,
+			sizeof(struct compat_vsp_bld_vir_t))) {
+		EPRINT("failed to copy of vsp_bld_vir_t\n");
+		return -EFAULT;
+	}
+
+	/* set */
+	vir->width = compat_vir.width;
+	vir->height = compat_vir.height;
+	vir->x_position = compat_vir.x_position;
+	vir->y_position = compat_vir.y_position;
+	vir->pwd = compat_vir.pwd;
+	vir->color = (unsigned long)compat_vir.color;
+
+	return 0;
+}
+
+static int set_compat_vsp_bru_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_entry_vsp_bru *bru,
+	unsigned int src)
+{
+	struct vsp_bld_ctrl_t **src_blend[5];
+	struct compat_vsp_bru_t compat_bru;
+	int ercd;
+	int i;
+
+	/* copy vsp_bru_t parameter */
+	if (copy_compat_par(
+			psrc,
+			&compat_bru,
+			src,
+			sizeof(struct compat_vsp_bru_t))) {
+		EPRINT("failed to copy of vsp_bru_t\n");
+		return -EFAULT;
+	}
+
+	bru->bru.lay_order = (unsigned long)compat_bru.lay_order;
+	bru->bru.adiv = compat_bru.adiv;
+	bru->bru.connect = (unsigned long)compat_bru.connect;
+
+	/* copy vsp_bld_dither_t parameter */
+	for (i = 0; i < 5; i++) {
+		if (compat_bru.dither_unit[i]) {
+			if (copy_compat_par(
+					psrc,
+					&bru->dither_unit[i],
+					compat_bru.dither_unit[i],
+					sizeof(struct vsp_bld_dither_t))) {
+				EPRINT("failed to copy of vsp_bld_dither_t\n");
+				return -EFAULT;
+			}
+			bru->bru.dither_unit[i] = &bru->dither_unit[i];
+		}
+	}
+
+	/* copy vsp_bld_vir_t parameter */
+	if (compat_bru.blend_virtual) {
+		ercd = set_compat_vsp_bru_vir_par(
+			psrc, &bru->blend_virtual, compat_bru.blend_virtual);
+		if (ercd)
+			return ercd;
+		bru->bru.blend_virtual = &bru->blend_virtual;
+	}
+
+	/* copy vsp_bld_ctrl_t parameter */
+	src_blend[0] = &bru->bru.blend_unit_a;
+	src_blend[1] = &bru->bru.blend_unit_b;
+	src_blend[2] = &bru->bru.blend_unit_c;
+	src_blend[3] = &bru->bru.blend_unit_d;
+	src_blend[4] = &bru->bru.blend_unit_e;
+
+	for (i = 0; i < 5; i++) {
+		if (compat_bru.blend_unit[i]) {
+			if (copy_compat_par(
+					psrc,
+					&bru->blend_unit[i],
+					compat_bru.blend_unit[i],
+					sizeof(struct vsp_bld_ctrl_t))) {
+				EPRINT("failed to copy of vsp_bld_ctrl_t\n");
+				return -EFAULT;
+			}
+			*src_blend[i] = &bru->blend_unit[i];
+		}
+	}
+
+	/* copy vsp_bld_rop_t parameter */
+	if (compat_bru.rop_unit) {
+		if (copy_compat_par(
+				psrc,
+				&bru->rop_unit,
+				compat_bru.rop_unit,
+				sizeof(struct vsp_bld_rop_t))) {
+			EPRINT("failed to copy of vsp_bld_rop_t\n");
+			return -EFAULT;
+		}
+		bru->bru.rop_unit = &bru->rop_unit;
+	}
+
+	return 0;
+}
+
+static int set_compat_vsp_hgo_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_entry_vsp_hgo *hgo,
+	unsigned int src,
+	struct vspm_if_work_buff_t *work_buff)
+{
+	struct compat_vsp_hgo_t compat_hgo;
+
+	/* copy */
+	if (copy_compat_par(
+			psrc,
+			&compat_hgo,
+			src,
+			sizeof(struct compat_vsp_hgo_t))) {
+		EPRINT("failed to copy of vsp_hgo_t\n");
+		return -EFAULT;
+	}
+
+	/* set */
+	hgo->hgo.width = compat_hgo.width;
+	hgo->hgo.height = compat_hgo.height;
+	hgo->hgo.x_offset = compat_hgo.x_offset;
+	hgo->hgo.y_offset = compat_hgo.y_offset;
+	hgo->hgo.binary_mode = compat_hgo.binary_mode;
+	hgo->hgo.maxrgb_mode = compat_hgo.maxrgb_mode;
+	hgo->hgo.step_mode = compat_hgo.step_mode;
+	hgo->hgo.x_skip = compat_hgo.x_skip;
+	hgo->hgo.y_skip = compat_hgo.y_skip;
+	hgo->hgo.sampling = (unsigned long)compat_hgo.sampling;
+
+	hgo->user_addr = VSPM_IF_INT_TO_VP(compat_hgo.virt_addr);
+
+	/* assign memory for histogram */
+	return set_vsp_hgo_buff(hgo, work_buff);
+}
+
+static int set_compat_vsp_hgt_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_entry_vsp_hgt *hgt,
+	unsigned int src,
+	struct vspm_if_work_buff_t *work_buff)
+{
+	struct compat_vsp_hgt_t compat_hgt;
+
+	int i;
+
+	/* copy */
+	if (copy_compat_par(
+			psrc,
+			&compat_hgt,
+			src,
+			sizeof(struct compat_vsp_hgt_t))) {
+		EPRINT("failed to copy of vsp_hgt_t\n");
+		return -EFAULT;
+	}
+
+	/* set */
+	hgt->hgt.width = compat_hgt.width;
+	hgt->hgt.height = compat_hgt.height;
+	hgt->hgt.x_offset = compat_hgt.x_offset;
+	hgt->hgt.y_offset = compat_hgt.y_offset;
+	hgt->hgt.x_skip = compat_hgt.x_skip;
+	hgt->hgt.y_skip = compat_hgt.y_skip;
+	for (i = 0; i < 6; i++) {
+		hgt->hgt.area[i].lower = compat_hgt.area[i].lower;
+		hgt->hgt.area[i].upper = compat_hgt.area[i].upper;
+	}
+	hgt->hgt.sampling = (unsigned long)compat_hgt.sampling;
+
+	hgt->user_addr = VSPM_IF_INT_TO_VP(compat_hgt.virt_addr);
+
+	/* assign memory for histogram */
+	return set_vsp_hgt_buff(hgt, work_buff);
+}
+
+static int set_compat_vsp_shp_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vsp_shp_t *shp,
+	unsigned int src)
+{
+	struct compat_vsp_shp_t compat_shp;
+
+	/* copy */
+	if (copy_compat_par(
+			psrc,
+			&compat_shp,
+			src,
+			sizeof(struct compat_vsp_shp_t))) {
+		EPRINT("failed to copy of vsp_shp_t\n");
+		return -EFAULT;
+	}
+
+	/* set */
+	shp->mode = compat_shp.mode;
+	shp->gain0 = compat_shp.gain0;
+	shp->limit0 = compat_shp.limit0;
+	shp->gain10 = compat_shp.gain10;
+	shp->limit10 = compat_shp.limit10;
+	shp->gain11 = compat_shp.gain11;
+	shp->limit11 = compat_shp.limit11;
+	shp->gain20 = compat_shp.gain20;
+	shp->limit20 = compat_shp.limit20;
+	shp->gain21 = compat_shp.gain21;
+	shp->limit21 = compat_shp.limit21;
+	shp->fxa = compat_shp.fxa;
+	shp->connect = (unsigned long)compat_shp.connect;
+
+	return 0;
+}
+
+static int set_compat_vsp_ctrl_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_entry_vsp_ctrl *ctrl,
+	unsigned int src,
+	struct vspm_if_work_buff_t *work_buff)
+{
+	struct compat_vsp_ctrl_t compat_vsp_ctrl;
+	int ercd;
+
+	/* copy vsp_ctrl_t parameter */
+	if (copy_compat_par(
+			psrc,
+			&compat_vsp_ctrl,
+			src,
+			sizeof(struct compat_vsp_ctrl_t))) {
+		EPRINT("failed to copy of vsp_ctrl_t\n");
+		return -EFAULT;
+	}
+
+	/* copy vsp_sru_t parameter */
+	if (compat_vsp_ctrl.sru) {
+		ercd = set_compat_vsp_sru_par(
+			psrc, &ctrl->sru, compat_vsp_ctrl.sru);
+		if (ercd)
+			return ercd;
+		ctrl->ctrl.sru = &ctrl->sru;
+	}
+
+	/* copy vsp_uds_t parameter */
+	if (compat_vsp_ctrl.uds) {
+		ercd = set_compat_vsp_uds_par(
+			psrc, &ctrl->uds, compat_vsp_ctrl.uds);
+		if (ercd)
+			return ercd;
+		ctrl->ctrl.uds = &ctrl->uds;
+	}
+
+	/* copy vsp_lut_t parameter */
+	if (compat_vsp_ctrl.lut) {
+		ercd = set_compat_vsp_lut_par(
+			psrc, &ctrl->lut, compat_vsp_ctrl.lut);
+		if (ercd)
+			return ercd;
+		ercd = set_vsp_tbl_par(&ctrl->lut.lut, work_buff);
+		if (ercd)
+			return ercd;
+		ctrl->ctrl.lut = &ctrl->lut;
+	}
+
+	/* copy vsp_clu_t parameter */
+	if (compat_vsp_ctrl.clu) {
+		ercd = set_compat_vsp_clu_par(
+			psrc, &ctrl->clu, compat_vsp_ctrl.clu);
+		if (ercd)
+			return ercd;
+		ercd = set_vsp_tbl_par(&ctrl->clu.clu, work_buff);
+		if (ercd)
+			return ercd;
+		ctrl->ctrl.clu = &ctrl->clu;
+	}
+
+	/* copy vsp_hst_t parameter */
+	if (compat_vsp_ctrl.hst) {
+		ercd = set_compat_vsp_hst_par(
+			psrc, &ctrl->hst, compat_vsp_ctrl.hst);
+		if (ercd)
+			return ercd;
+		ctrl->ctrl.hst = &ctrl->hst;
+	}
+
+	/* copy vsp_hsi_t parameter */
+	if (compat_vsp_ctrl.hsi) {
+		ercd = set_compat_vsp_hsi_par(
+			psrc, &ctrl->hsi, compat_vsp_ctrl.hsi);
+		if (ercd)
+			return ercd;
+		ctrl->ctrl.hsi = &ctrl->hsi;
+	}
+
+	/* copy vsp_bru_t parameter */
+	if (compat_vsp_ctrl.bru) {
+		ercd = set_compat_vsp_bru_par(
+			psrc, &ctrl->bru, compat_vsp_ctrl.bru);
+		if (ercd)
+			return ercd;
+		ctrl->ctrl.bru = &ctrl->bru.bru;
+	}
+
+	/* copy vsp_hgo_t parameter */
+	if (compat_vsp_ctrl.hgo) {
+		ercd = set_compat_vsp_hgo_par(
+			psrc, &ctrl->hgo, compat_vsp_ctrl.hgo, work_buff);
+		if (ercd)
+			return ercd;
+		ctrl->ctrl.hgo = &ctrl->hgo.hgo;
+	}
+
+	/* copy vsp_hgt_t parameter */
+	if (compat_vsp_ctrl.hgt) {
+		ercd = set_compat_vsp_hgt_par(
+			psrc, &ctrl->hgt, compat_vsp_ctrl.hgt, work_buff);
+		if (ercd)
+			return ercd;
+		ctrl->ctrl.hgt = &ctrl->hgt.hgt;
+	}
+
+	/* copy vsp_shp_t parameter */
+	if (compat_vsp_ctrl.shp) {
+		ercd = set_compat_vsp_shp_par(
+			psrc, &ctrl->shp, compat_vsp_ctrl.shp);
+		if (ercd)
+			return ercd;
+		ctrl->ctrl.shp = &ctrl->shp;
 	}
 
 	return 0;
 }
 
-static int set_compat_vsp_src_clut_par(
-	struct vsp_dl_t *clut,
-	unsigned int src,
-	struct vspm_if_work_buff_t *work_buff)
+int set_compat_vsp_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_if_entry_data_t *entry,
+	unsigned int src)
 {
-	struct compat_vsp_dl_t compat_dl_par;
-	unsigned long tmp_addr;
+	struct vspm_entry_vsp *vsp = &entry->ip_par.vsp;
+	struct compat_vsp_start_t compat_vsp_par;
 
-	/* copy */
-	if (copy_from_user(
-			&compat_dl_par,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_dl_t))) {
-		EPRINT("failed to copy of vsp_dl_t\n");
+	int ercd;
+
+	int i;
+
+	/* copy vsp_start_t parameter */
+	if (copy_compat_par(
+			psrc,
+			&compat_vsp_par,
+			src,
+			sizeof(struct compat_vsp_start_t))) {
+		EPRINT("failed to copy of vsp_start_t\n");
 		return -EFAULT;
 	}
 
-	if (compat_dl_par.virt_addr != 0 &&
-	    compat_dl_par.tbl_num > 0 &&
-	    compat_dl_par.tbl_num <= 256) {
-		tmp_addr =
-			(unsigned long)work_buff->virt_addr +
-			(unsigned long)work_buff->offset;
+	vsp->par.rpf_num = compat_vsp_par.rpf_num;
+	vsp->par.rpf_order = 0;	/* not used */
+	vsp->par.use_module = (unsigned long)compat_vsp_par.use_module;
 
-		/* copy color table */
-		if (copy_from_user(
-				(void *)tmp_addr,
-				VSPM_IF_INT_TO_UP(compat_dl_par.virt_addr),
-				compat_dl_par.tbl_num * 8)) {
-			EPRINT("failed to copy color table\n");
-			return -EFAULT;
+	/* get work buffer */
+	vsp->work_buff = get_work_buffer(entry->priv);
+	if (!vsp->work_buff)
+		return -EFAULT;
+
+	/* copy vsp_src_t parameter */
+	for (i = 0; i < 5; i++) {
+		if (compat_vsp_par.src_par[i]) {
+			ercd = set_compat_vsp_src_par(
+				psrc,
+				&vsp->in[i],
+				compat_vsp_par.src_par[i],
+				vsp->work_buff);
+			if (ercd)
+				goto err_exit;
+			vsp->par.src_par[i] = &vsp->in[i].in;
 		}
+	}
 
-		/* set parameter */
-		clut->virt_addr = (void *)tmp_addr;
-		tmp_addr =
-			(unsigned long)work_buff->hard_addr +
-			(unsigned long)work_buff->offset;
-		clut->hard_addr = (unsigned int)tmp_addr;
-		clut->tbl_num = compat_dl_par.tbl_num;
+	/* copy vsp_dst_t parameter */
+	if (compat_vsp_par.dst_par) {
+		ercd = set_compat_vsp_dst_par(
+			psrc, &vsp->out, compat_vsp_par.dst_par);
+		if (ercd)
+			goto err_exit;
+		vsp->par.dst_par = &vsp->out.out;
+	}
 
-		/* increment memory offset */
-		work_buff->offset += VSPM_IF_RPF_CLUT_SIZE;
+	/* copy vsp_ctrl_t parameter */
+	if (compat_vsp_par.ctrl_par) {
+		ercd = set_compat_vsp_ctrl_par(
+			psrc,
+			&vsp->ctrl,
+			compat_vsp_par.ctrl_par,
+			vsp->work_buff);
+		if (ercd)
+			goto err_exit;
+		vsp->par.ctrl_par = &vsp->ctrl.ctrl;
 	}
 
+	/* assign memory for display list */
+	ercd = set_vsp_dl_buff(vsp);
+	if (ercd)
+		goto err_exit;
+
 	return 0;
+
+err_exit:
+	free_vsp_par(vsp);
+	return ercd;
 }
 
-static int set_compat_vsp_irop_par(
-	struct vsp_irop_unit_t *irop, unsigned int src)
+static int set_compat_fdp_pic_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct fdp_pic_t *in_pic,
+	unsigned int src)
 {
-	struct compat_vsp_irop_unit_t compat_irop;
+	struct compat_fdp_pic_t compat_fdp_pic;
 
 	/* copy */
-	if (copy_from_user(
-			&compat_irop,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_irop_unit_t))) {
-		EPRINT("failed to copy of vsp_irop_unit_t\n");
+	if (copy_compat_par(
+			psrc,
+			&compat_fdp_pic,
+			src,
+			sizeof(struct compat_fdp_pic_t))) {
+		EPRINT("failed to copy of fdp_pic_t\n");
 		return -EFAULT;
 	}
 
 	/* set */
-	irop->op_mode = compat_irop.op_mode;
-	irop->ref_sel = compat_irop.ref_sel;
-	irop->bit_sel = compat_irop.bit_sel;
-	irop->comp_color = (unsigned long)compat_irop.comp_color;
-	irop->irop_color0 = (unsigned long)compat_irop.irop_color0;
-	irop->irop_color1 = (unsigned long)compat_irop.irop_color1;
+	in_pic->picid = (unsigned long)compat_fdp_pic.picid;
+	in_pic->chroma_format = compat_fdp_pic.chroma_format;
+	in_pic->width = compat_fdp_pic.width;
+	in_pic->height = compat_fdp_pic.height;
+	in_pic->progressive_sequence = compat_fdp_pic.progressive_sequence;
+	in_pic->progressive_frame = compat_fdp_pic.progressive_frame;
+	in_pic->picture_structure = compat_fdp_pic.picture_structure;
+	in_pic->repeat_first_field = compat_fdp_pic.repeat_first_field;
+	in_pic->top_field_first = compat_fdp_pic.top_field_first;
 
 	return 0;
 }
 
-static int set_compat_vsp_ckey_par(
-	struct vsp_ckey_unit_t *ckey, unsigned int src)
+static int set_compat_fdp_ref_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_entry_fdp_ref *ref,
+	unsigned int src)
 {
-	struct compat_vsp_ckey_unit_t compat_ckey;
+	struct compat_fdp_refbuf_t compat_fdp_refbuf;
 
-	/* copy */
-	if (copy_from_user(
-			&compat_ckey,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_ckey_unit_t))) {
-		EPRINT("failed to copy of vsp_ckey_unit_t\n");
+	/* copy fdp_refbuf_t parameter */
+	if (copy_compat_par(
+			psrc,
+			&compat_fdp_refbuf,
+			src,
+			sizeof(struct compat_fdp_refbuf_t))) {
+		EPRINT("failed to copy of fdp_refbuf_t\n");
 		return -EFAULT;
 	}
 
-	/* set */
-	ckey->mode = compat_ckey.mode;
-	ckey->color1 = (unsigned long)compat_ckey.color1;
-	ckey->color2 = (unsigned long)compat_ckey.color2;
+	if (compat_fdp_refbuf.next_buf) {
+		if (copy_compat_par(
+				psrc,
+				&ref->ref[0],
+				compat_fdp_refbuf.next_buf,
+				sizeof(struct fdp_imgbuf_t))) {
+			EPRINT("failed to copy to fdp_imgbuf_t\n");
+			return -EFAULT;
+		}
+		ref->ref_buf.next_buf = &ref->ref[0];
+	}
+
+	if (compat_fdp_refbuf.cur_buf) {
+		if (copy_compat_par(
+				psrc,
+				&ref->ref[1],
+				compat_fdp_refbuf.cur_buf,
+				sizeof(struct fdp_imgbuf_t))) {
+			EPRINT("failed to copy to fdp_imgbuf_t\n");
+			return -EFAULT;
+		}
+		ref->ref_buf.cur_buf = &ref->ref[1];
+	}
+
+	if (compat_fdp_refbuf.prev_buf) {
+		if (copy_compat_par(
+				psrc,
+				&ref->ref[2],
+				compat_fdp_refbuf.prev_buf,
+				sizeof(struct fdp_imgbuf_t))) {
+			EPRINT("failed to copy to fdp_imgbuf_t\n");
+			return -EFAULT;
+		}
+		ref->ref_buf.prev_buf = &ref->ref[2];
+	}
 
 	return 0;
 }
 
-static int set_compat_vsp_src_alpha_par(
-	struct vspm_entry_vsp_in_alpha *alpha, unsigned int src)
+static int set_compat_fdp_fproc_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_entry_fdp_fproc *fproc,
+	unsigned int src)
 {
-	struct compat_vsp_alpha_unit_t compat_alpha;
+	struct compat_fdp_fproc_t compat_fdp_fproc;
 	int ercd;
 
-	/* copy vsp_alpha_unit_t parameter */
-	if (copy_from_user(
-			&compat_alpha,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_alpha_unit_t))) {
-		EPRINT("failed to copy of vsp_alpha_unit_t\n");
+	/* copy fdp_fproc_t parameter */
+	if (copy_compat_par(
+			psrc,
+			&compat_fdp_fproc,
+			src,
+			sizeof(struct compat_fdp_fproc_t))) {
+		EPRINT("failed to copy of fdp_fproc_t\n");
 		return -EFAULT;
 	}
 
-	alpha->alpha.addr_a = compat_alpha.addr_a;
-	alpha->alpha.stride_a = compat_alpha.stride_a;
-	alpha->alpha.swap = compat_alpha.swap;
-	alpha->alpha.asel = compat_alpha.asel;
-	alpha->alpha.aext = compat_alpha.aext;
-	alpha->alpha.anum0 = compat_alpha.anum0;
-	alpha->alpha.anum1 = compat_alpha.anum1;
-	alpha->alpha.afix = compat_alpha.afix;
+	fproc->fproc.last_seq_indicator = compat_fdp_fproc.last_seq_indicator;
+	fproc->fproc.current_field = compat_fdp_fproc.current_field;
+	fproc->fproc.interpolated_line = compat_fdp_fproc.interpolated_line;
+	fproc->fproc.out_format = compat_fdp_fproc.out_format;
 
-	/* copy vsp_irop_unit_t paramerter */
-	if (compat_alpha.irop) {
-		ercd = set_compat_vsp_irop_par(&alpha->irop, compat_alpha.irop);
-		if (ercd)
-			return ercd;
-		alpha->alpha.irop = &alpha->irop;
+	/* copy fdp_seq_t parameter */
+	if (compat_fdp_fproc.seq_par) {
+		if (copy_compat_par(
+				psrc,
+				&fproc->seq,
+				compat_fdp_fproc.seq_par,
+				sizeof(struct fdp_seq_t))) {
+			EPRINT("failed to copy to fdp_seq_t\n");
+			return -EFAULT;
+		}
+		fproc->fproc.seq_par = &fproc->seq;
 	}
 
-	/* copy vsp_ckey_unit_t paramerter */
-	if (compat_alpha.ckey) {
-		ercd = set_compat_vsp_ckey_par(&alpha->ckey, compat_alpha.ckey);
+	/* copy fdp_pic_t parameter */
+	if (compat_fdp_fproc.in_pic) {
+		ercd = set_compat_fdp_pic_par(
+			psrc, &fproc->in_pic, compat_fdp_fproc.in_pic);
 		if (ercd)
 			return ercd;
-		alpha->alpha.ckey = &alpha->ckey;
+		fproc->fproc.in_pic = &fproc->in_pic;
 	}
 
-	/* copy vsp_mult_unit_t paramerter */
-	if (compat_alpha.mult) {
-		if (copy_from_user(
-				&alpha->mult,
-				VSPM_IF_INT_TO_UP(compat_alpha.mult),
-				sizeof(struct vsp_mult_unit_t))) {
-			EPRINT("failed to copy of vsp_mult_unit_t\n");
+	/* copy fdp_imgbuf_t parameter */
+	if (compat_fdp_fproc.out_buf) {
+		if (copy_compat_par(
+				psrc,
+				&fproc->out_buf,
+				compat_fdp_fproc.out_buf,
+				sizeof(struct fdp_imgbuf_t))) {
+			EPRINT("failed to copy to fdp_imgbuf_t\n");
 			return -EFAULT;
 		}
-		alpha->alpha.mult = &alpha->mult;
-	}
-
-	return 0;
-}
-
-static int set_compat_vsp_src_par(
-	struct vspm_entry_vsp_in *in,
-	unsigned int src,
-	struct vspm_if_work_buff_t *work_buff)
-{
-	struct compat_vsp_src_t compat_vsp_src;
-	int ercd;
-
-	/* copy vsp_src_t parameter */
-	if (copy_from_user(
-			&compat_vsp_src,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_src_t))) {
-		EPRINT("failed to copy of vsp_src_t\n");
-		return -EFAULT;
+		fproc->fproc.out_buf = &fproc->out_buf;
 	}
 
-	in->in.addr = compat_vsp_src.addr;
-	in->in.addr_c0 = compat_vsp_src.addr_c0;
-	in->in.addr_c1 = compat_vsp_src.addr_c1;
-	in->in.stride = compat_vsp_src.stride;
-	in->in.stride_c = compat_vsp_src.stride_c;
-	in->in.width = compat_vsp_src.width;
-	in->in.height = compat_vsp_src.height;
-	in->in.width_ex = compat_vsp_src.width_ex;
-	in->in.height_ex = compat_vsp_src.height_ex;
-	in->in.x_offset = compat_vsp_src.x_offset;
-	in->in.y_offset = compat_vsp_src.y_offset;
-	in->in.format = compat_vsp_src.format;
-	in->in.swap = compat_vsp_src.swap;
-	in->in.x_position = compat_vsp_src.x_position;
-	in->in.y_position = compat_vsp_src.y_position;
-	in->in.pwd = compat_vsp_src.pwd;
-	in->in.cipm = compat_vsp_src.cipm;
-	in->in.cext = compat_vsp_src.cext;
-	in->in.csc = compat_vsp_src.csc;
-	in->in.iturbt = compat_vsp_src.iturbt;
-	in->in.clrcng = compat_vsp_src.clrcng;
-	in->in.vir = compat_vsp_src.vir;
-	in->in.vircolor = (unsigned long)compat_vsp_src.vircolor;
-	in->in.connect = (unsigned long)compat_vsp_src.connect;
-
-	/* copy vsp_dl_t parameter */
-	if (compat_vsp_src.clut) {
-		ercd = set_compat_vsp_src_clut_par(
-			&in->clut, compat_vsp_src.clut, work_buff);
+	/* copy fdp_refbuf_t parameter */
+	if (compat_fdp_fproc.ref_buf) {
+		ercd = set_compat_fdp_ref_par(
+			psrc, &fproc->ref, compat_fdp_fproc.ref_buf);
 		if (ercd)
 			return ercd;
-		in->in.clut = &in->clut;
+		fproc->fproc.ref_buf = &fproc->ref.ref_buf;
+	}
+
+	/* copy fcp_info_t parameter */
+	if (compat_fdp_fproc.fcp_par) {
+		if (copy_compat_par(
+				psrc,
+				&fproc->fcp,
+				compat_fdp_fproc.fcp_par,
+				sizeof(struct fcp_info_t))) {
+			EPRINT("failed to copy to fcp_info_t\n");
+			return -EFAULT;
+		}
+		fproc->fproc.fcp_par = &fproc->fcp;
 	}
 
-	/* copy vsp_alpha_unit_t parameter */
-	if (compat_vsp_src.alpha) {
-		ercd = set_compat_vsp_src_alpha_par(
-			&in->alpha, compat_vsp_src.alpha);
-		if (ercd)
-			return ercd;
-		in->in.alpha = &in->alpha.alpha;
+	/* copy fdp_ipc_t parameter */
+	if (compat_fdp_fproc.ipc_par) {
+		if (copy_compat_par(
+				psrc,
+				&fproc->ipc,
+				compat_fdp_fproc.ipc_par,
+				sizeof(struct fdp_ipc_t))) {
+			EPRINT("failed to copy to fdp_ipc_t\n");
+			return -EFAULT;
+		}
+		fproc->fproc.ipc_par = &fproc->ipc;
 	}
 
 	return 0;
 }
 
-static int set_compat_vsp_dst_par(
-	struct vspm_entry_vsp_out *out, unsigned int src)
+int set_compat_fdp_par(
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_if_entry_data_t *entry,
+	unsigned int src)
 {
-	struct compat_vsp_dst_t compat_vsp_dst;
+	struct vspm_entry_fdp *fdp = &entry->ip_par.fdp;
+	struct compat_fdp_start_t compat_fdp_par;
+	int ercd;
 
-	/* copy vsp_dst_t parameter */
-	if (copy_from_user(
-			&compat_vsp_dst,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_dst_t))) {
-		EPRINT("failed to copy of vsp_dst_t\n");
+	/* copy fdp_start_t parameter */
+	if (copy_compat_par(
+			psrc,
+			&compat_fdp_par,
+			src,
+			sizeof(struct compat_fdp_start_t))) {
+		EPRINT("failed to copy of fdp_start_t\n");
 		return -EFAULT;
 	}
 
-	out->out.addr = compat_vsp_dst.addr;
-	out->out.addr_c0 = compat_vsp_dst.addr_c0;
-	out->out.addr_c1 = compat_vsp_dst.addr_c1;
-	out->out.stride = compat_vsp_dst.stride;
-	out->out.stride_c = compat_vsp_dst.stride_c;
-	out->out.width = compat_vsp_dst.width;
-	out->out.height = compat_vsp_dst.height;
-	out->out.x_offset = compat_vsp_dst.x_offset;
-	out->out.y_offset = compat_vsp_dst.y_offset;
-	out->out.format = compat_vsp_dst.format;
-	out->out.swap = compat_vsp_dst.swap;
-	out->out.pxa = compat_vsp_dst.pxa;
-	out->out.pad = compat_vsp_dst.pad;
-	out->out.x_coffset = compat_vsp_dst.x_coffset;
-	out->out.y_coffset = compat_vsp_dst.y_coffset;
-	out->out.csc = compat_vsp_dst.csc;
-	out->out.iturbt = compat_vsp_dst.iturbt;
-	out->out.clrcng = compat_vsp_dst.clrcng;
-	out->out.cbrm = compat_vsp_dst.cbrm;
-	out->out.abrm = compat_vsp_dst.abrm;
-	out->out.athres = compat_vsp_dst.athres;
-	out->out.clmd = compat_vsp_dst.clmd;
-	out->out.dith = compat_vsp_dst.dith;
-	out->out.rotation = compat_vsp_dst.rotation;
+	fdp->par.fdpgo = compat_fdp_par.fdpgo;
 
-	/* copy fcp_info_t parameter */
-	if (compat_vsp_dst.fcp) {
-		if (copy_from_user(
-				&out->fcp,
-				VSPM_IF_INT_TO_UP(compat_vsp_dst.fcp),
-				sizeof(struct fcp_info_t))) {
-			EPRINT("failed to copy to fcp_info_t\n");
-			return -EFAULT;
-		}
-		out->out.fcp = &out->fcp;
+	/* copy fdp_fproc_t parameter */
+	if (compat_fdp_par.fproc_par) {
+		ercd = set_compat_fdp_fproc_par(
+			psrc, &fdp->fproc, compat_fdp_par.fproc_par);
+		if (ercd)
+			return ercd;
+		fdp->par.fproc_par = &fdp->fproc.fproc;
 	}
 
 	return 0;
 }
 
-static int set_compat_vsp_sru_par(struct vsp_sru_t *sru, unsigned int src)
+int set_compat_job_par(
+	struct vspm_if_entry_data_t *entry_data,
+	const struct vspm_if_par_src_t *psrc,
+	struct vspm_compat_job_t *compat_job)
 {
-	struct compat_vsp_sru_t compat_sru;
+	int ercd;
 
-	/* copy */
-	if (copy_from_user(
-			&compat_sru,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_sru_t))) {
-		EPRINT("failed to copy of vsp_sru_t\n");
-		return -EFAULT;
+	entry_data->job.type = compat_job->type;
+
+	switch (compat_job->type) {
+	case VSPM_TYPE_VSP_AUTO:
+		/* copy start parameter of VSP */
+		if (compat_job->par.vsp) {
+			ercd = set_compat_vsp_par(
+				psrc, entry_data, compat_job->par.vsp);
+			if (ercd)
+				return ercd;
+
+			entry_data->job.par.vsp =
+				&entry_data->ip_par.vsp.par;
+		}
+		break;
+	case VSPM_TYPE_FDP_AUTO:
+		/* copy start parameter of FDP */
+		if (compat_job->par.fdp) {
+			ercd = set_compat_fdp_par(
+				psrc, entry_data, compat_job->par.fdp);
+			if (ercd)
+				return ercd;
+
+			entry_data->job.par.fdp =
+				&entry_data->ip_par.fdp.par;
+		}
+		break;
+	default:
+		break;
 	}
 
-	/* set */
-	sru->mode = compat_sru.mode;
-	sru->param = compat_sru.param;
-	sru->enscl = compat_sru.enscl;
-	sru->fxa = compat_sru.fxa;
-	sru->connect = (unsigned long)compat_sru.connect;
+	entry_data->entry.req.job_param = &entry_data->job;
 
 	return 0;
 }
 
-static int set_compat_vsp_uds_par(struct vsp_uds_t *uds, unsigned int src)
+static void copy_vsp_par(
+	struct vspm_entry_vsp *vsp, const struct vspm_entry_vsp *tmpl)
 {
-	struct compat_vsp_uds_t compat_uds;
+	struct vspm_entry_vsp_ctrl *ctrl = &vsp->ctrl;
+	struct vsp_bld_ctrl_t **blend[5];
+	int i;
 
-	/* copy */
-	if (copy_from_user(
-			&compat_uds,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_uds_t))) {
-		EPRINT("failed to copy of vsp_uds_t\n");
-		return -EFAULT;
+	*vsp = *tmpl;
+
+	/* link vsp_src_t parameter to own copy */
+	for (i = 0; i < 5; i++) {
+		struct vspm_entry_vsp_in *in = &vsp->in[i];
+
+		if (!vsp->par.src_par[i])
+			continue;
+		vsp->par.src_par[i] = &in->in;
+
+		if (in->in.clut)
+			in->in.clut = &in->clut;
+
+		if (in->in.alpha) {
+			in->in.alpha = &in->alpha.alpha;
+			if (in->alpha.alpha.irop)
+				in->alpha.alpha.irop = &in->alpha.irop;
+			if (in->alpha.alpha.ckey)
+				in->alpha.alpha.ckey = &in->alpha.ckey;
+			if (in->alpha.alpha.mult)
+				in->alpha.alpha.mult = &in->alpha.mult;
+		}
 	}
 
-	/* set */
-	uds->amd = compat_uds.amd;
-	uds->clip = compat_uds.clip;
-	uds->alpha = compat_uds.alpha;
-	uds->complement = compat_uds.complement;
-	uds->athres0 = compat_uds.athres0;
-	uds->athres1 = compat_uds.athres1;
-	uds->anum0 = compat_uds.anum0;
-	uds->anum1 = compat_uds.anum1;
-	uds->anum2 = compat_uds.anum2;
-	uds->x_ratio = compat_uds.x_ratio;
-	uds->y_ratio = compat_uds.y_ratio;
-	uds->connect = (unsigned long)compat_uds.connect;
+	/* link vsp_dst_t parameter to own copy */
+	if (vsp->par.dst_par) {
+		vsp->par.dst_par = &vsp->out.out;
+		if (vsp->out.out.fcp)
+			vsp->out.out.fcp = &vsp->out.fcp;
+	}
 
-	return 0;
+	/* link vsp_ctrl_t parameter to own copy */
+	if (!vsp->par.ctrl_par)
+		return;
+	vsp->par.ctrl_par = &ctrl->ctrl;
+
+	if (ctrl->ctrl.sru)
+		ctrl->ctrl.sru = &ctrl->sru;
+	if (ctrl->ctrl.uds)
+		ctrl->ctrl.uds = &ctrl->uds;
+	if (ctrl->ctrl.lut)
+		ctrl->ctrl.lut = &ctrl->lut;
+	if (ctrl->ctrl.clu)
+		ctrl->ctrl.clu = &ctrl->clu;
+	if (ctrl->ctrl.hst)
+		ctrl->ctrl.hst = &ctrl->hst;
+	if (ctrl->ctrl.hsi)
+		ctrl->ctrl.hsi = &ctrl->hsi;
+	if (ctrl->ctrl.hgo)
+		ctrl->ctrl.hgo = &ctrl->hgo.hgo;
+	if (ctrl->ctrl.hgt)
+		ctrl->ctrl.hgt = &ctrl->hgt.hgt;
+	if (ctrl->ctrl.shp)
+		ctrl->ctrl.shp = &ctrl->shp;
+
+	if (ctrl->ctrl.bru) {
+		struct vspm_entry_vsp_bru *bru = &ctrl->bru;
+
+		ctrl->ctrl.bru = &bru->bru;
+
+		for (i = 0; i < 5; i++) {
+			if (bru->bru.dither_unit[i])
+				bru->bru.dither_unit[i] = &bru->dither_unit[i];
+		}
+
+		if (bru->bru.blend_virtual)
+			bru->bru.blend_virtual = &bru->blend_virtual;
+
+		blend[0] = &bru->bru.blend_unit_a;
+		blend[1] = &bru->bru.blend_unit_b;
+		blend[2] = &bru->bru.blend_unit_c;
+		blend[3] = &bru->bru.blend_unit_d;
+		blend[4] = &bru->bru.blend_unit_e;
+
+		for (i = 0; i < 5; i++) {
+			if (*blend[i])
+				*blend[i] = &bru->blend_unit[i];
+		}
+
+		if (bru->bru.rop_unit)
+			bru->bru.rop_unit = &bru->rop_unit;
+	}
 }
 
-static int set_compat_vsp_lut_par(struct vsp_lut_t *lut, unsigned int src)
+static int set_tmpl_vsp_par(
+	struct vspm_if_entry_data_t *entry,
+	const struct vspm_entry_vsp *tmpl,
+	const struct vspm_if_tmpl_entry_req_t *req)
 {
-	struct compat_vsp_lut_t compat_lut;
+	struct vspm_entry_vsp *vsp = &entry->ip_par.vsp;
+	struct vspm_entry_vsp_ctrl *ctrl = &vsp->ctrl;
+	int ercd;
+	int i;
 
-	/* copy */
-	if (copy_from_user(
-			&compat_lut,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_lut_t))) {
-		EPRINT("failed to copy of vsp_lut_t\n");
-		return -EFAULT;
+	/* copy registered parameter */
+	copy_vsp_par(vsp, tmpl);
+
+	/* the work buffer of template keeps only the color tables */
+	vsp->work_buff = NULL;
+
+	/* patch the address of vsp_src_t */
+	for (i = 0; i < 5; i++) {
+		if (req->patch & VSPM_IF_TMPL_PATCH_SRC(i)) {
+			if (!vsp->par.src_par[i])
+				return -EINVAL;
+			vsp->in[i].in.addr = req->src[i].addr;
+			vsp->in[i].in.addr_c0 = req->src[i].addr_c0;
+			vsp->in[i].in.addr_c1 = req->src[i].addr_c1;
+		}
 	}
 
-	/* set */
-	lut->lut.hard_addr = compat_lut.lut.hard_addr;
-	lut->lut.virt_addr = VSPM_IF_INT_TO_VP(compat_lut.lut.virt_addr);
-	lut->lut.tbl_num = compat_lut.lut.tbl_num;
-	lut->fxa = compat_lut.fxa;
-	lut->connect = (unsigned long)compat_lut.connect;
+	/* patch the address of vsp_dst_t */
+	if (req->patch & VSPM_IF_TMPL_PATCH_DST) {
+		if (!vsp->par.dst_par)
+			return -EINVAL;
+		vsp->out.out.addr = req->dst.addr;
+		vsp->out.out.addr_c0 = req->dst.addr_c0;
+		vsp->out.out.addr_c1 = req->dst.addr_c1;
+	}
 
-	return 0;
+	/* get work buffer */
+	vsp->work_buff = get_work_buffer(entry->priv);
+	if (!vsp->work_buff)
+		return -EFAULT;
+
+	/* assign memory for histogram */
+	if (vsp->par.ctrl_par) {
+		if (ctrl->ctrl.hgo) {
+			ercd = set_vsp_hgo_buff(&ctrl->hgo, vsp->work_buff);
+			if (ercd)
+				return ercd;
+			ctrl->hgo.user_addr = VSPM_IF_INT_TO_VP(req->hgo_addr);
+		}
+		if (ctrl->ctrl.hgt) {
+			ercd = set_vsp_hgt_buff(&ctrl->hgt, vsp->work_buff);
+			if (ercd)
+				return ercd;
+			ctrl->hgt.user_addr = VSPM_IF_INT_TO_VP(req->hgt_addr);
+		}
+	}
+
+	/* assign memory for display list */
+	return set_vsp_dl_buff(vsp);
 }
 
-static int set_compat_vsp_clu_par(struct vsp_clu_t *clu, unsigned int src)
+static void copy_fdp_par(
+	struct vspm_entry_fdp *fdp, const struct vspm_entry_fdp *tmpl)
 {
-	struct compat_vsp_clu_t compat_clu;
+	struct vspm_entry_fdp_fproc *fproc = &fdp->fproc;
+	struct vspm_entry_fdp_ref *ref = &fproc->ref;
 
-	/* copy */
-	if (copy_from_user(
-			&compat_clu,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_clu_t))) {
-		EPRINT("failed to copy of vsp_clu_t\n");
-		return -EFAULT;
-	}
+	*fdp = *tmpl;
 
-	/* set */
-	clu->mode = compat_clu.mode;
-	clu->clu.hard_addr = compat_clu.clu.hard_addr;
-	clu->clu.virt_addr = VSPM_IF_INT_TO_VP(compat_clu.clu.virt_addr);
-	clu->clu.tbl_num = compat_clu.clu.tbl_num;
-	clu->fxa = compat_clu.fxa;
-	clu->connect = (unsigned long)compat_clu.connect;
+	if (!fdp->par.fproc_par)
+		return;
+	fdp->par.fproc_par = &fproc->fproc;
 
-	return 0;
+	/* link fdp_fproc_t parameter to own copy */
+	if (fproc->fproc.seq_par)
+		fproc->fproc.seq_par = &fproc->seq;
+	if (fproc->fproc.in_pic)
+		fproc->fproc.in_pic = &fproc->in_pic;
+	if (fproc->fproc.out_buf)
+		fproc->fproc.out_buf = &fproc->out_buf;
+	if (fproc->fproc.fcp_par)
+		fproc->fproc.fcp_par = &fproc->fcp;
+	if (fproc->fproc.ipc_par)
+		fproc->fproc.ipc_par = &fproc->ipc;
+
+	if (fproc->fproc.ref_buf) {
+		fproc->fproc.ref_buf = &ref->ref_buf;
+		if (ref->ref_buf.next_buf)
+			ref->ref_buf.next_buf = &ref->ref[0];
+		if (ref->ref_buf.cur_buf)
+			ref->ref_buf.cur_buf = &ref->ref[1];
+		if (ref->ref_buf.prev_buf)
+			ref->ref_buf.prev_buf = &ref->ref[2];
+	}
 }
 
-static int set_compat_vsp_hst_par(struct vsp_hst_t *hst, unsigned int src)
+static int set_tmpl_fdp_par(
+	struct vspm_if_entry_data_t *entry,
+	const struct vspm_entry_fdp *tmpl,
+	const struct vspm_if_tmpl_entry_req_t *req)
 {
-	struct compat_vsp_hst_t compat_hst;
+	struct vspm_entry_fdp *fdp = &entry->ip_par.fdp;
+	struct fdp_imgbuf_t *ref_buf[3];
+	int i;
 
-	/* copy */
-	if (copy_from_user(
-			&compat_hst,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_hst_t))) {
-		EPRINT("failed to copy of vsp_hst_t\n");
-		return -EFAULT;
+	/* copy registered parameter */
+	copy_fdp_par(fdp, tmpl);
+
+	/* patch the address of output buffer */
+	if (req->patch & VSPM_IF_TMPL_PATCH_FDP_OUT) {
+		if (!fdp->par.fproc_par || !fdp->fproc.fproc.out_buf)
+			return -EINVAL;
+		fdp->fproc.out_buf.addr = req->fdp_out.addr;
+		fdp->fproc.out_buf.addr_c0 = req->fdp_out.addr_c0;
+		fdp->fproc.out_buf.addr_c1 = req->fdp_out.addr_c1;
 	}
 
-	/* set */
-	hst->fxa = compat_hst.fxa;
-	hst->connect = (unsigned long)compat_hst.connect;
+	/* patch the address of reference buffers */
+	if (fdp->par.fproc_par && fdp->fproc.fproc.ref_buf) {
+		ref_buf[0] = fdp->fproc.ref.ref_buf.next_buf;
+		ref_buf[1] = fdp->fproc.ref.ref_buf.cur_buf;
+		ref_buf[2] = fdp->fproc.ref.ref_buf.prev_buf;
+	} else {
+		ref_buf[0] = NULL;
+		ref_buf[1] = NULL;
+		ref_buf[2] = NULL;
+	}
+
+	for (i = 0; i < 3; i++) {
+		if (req->patch & VSPM_IF_TMPL_PATCH_FDP_REF(i)) {
+			if (!ref_buf[i])
+				return -EINVAL;
+			ref_buf[i]->addr = req->fdp_ref[i].addr;
+			ref_buf[i]->addr_c0 = req->fdp_ref[i].addr_c0;
+			ref_buf[i]->addr_c1 = req->fdp_ref[i].addr_c1;
+		}
+	}
 
 	return 0;
 }
 
-static int set_compat_vsp_hsi_par(struct vsp_hsi_t *hsi, unsigned int src)
+int set_tmpl_par(
+	struct vspm_if_entry_data_t *entry,
+	const struct vspm_if_entry_data_t *tmpl,
+	const struct vspm_if_tmpl_entry_req_t *req)
 {
-	struct compat_vsp_hsi_t compat_hsi;
+	int ercd;
 
-	/* copy */
-	if (copy_from_user(
-			&compat_hsi,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_hsi_t))) {
-		EPRINT("failed to copy of vsp_hsi_t\n");
-		return -EFAULT;
+	entry->job = tmpl->job;
+
+	switch (entry->job.type) {
+	case VSPM_TYPE_VSP_AUTO:
+		if (entry->job.par.vsp) {
+			ercd = set_tmpl_vsp_par(entry, &tmpl->ip_par.vsp, req);
+			if (ercd)
+				return ercd;
+			entry->job.par.vsp = &entry->ip_par.vsp.par;
+		}
+		break;
+	case VSPM_TYPE_FDP_AUTO:
+		if (entry->job.par.fdp) {
+			ercd = set_tmpl_fdp_par(entry, &tmpl->ip_par.fdp, req);
+			if (ercd)
+				return ercd;
+			entry->job.par.fdp = &entry->ip_par.fdp.par;
+		}
+		break;
+	default:
+		break;
 	}
 
-	/* set */
-	hsi->fxa = compat_hsi.fxa;
-	hsi->connect = (unsigned long)compat_hsi.connect;
+	entry->entry.req.job_param = &entry->job;
 
 	return 0;
 }
 
-static int set_compat_vsp_bru_vir_par(
-	struct vsp_bld_vir_t *vir, unsigned int src)
+static void release_tmpl(struct kref *ref)
 {
-	struct compat_vsp_bld_vir_t compat_vir;
+	struct vspm_if_tmpl_t *tmpl =
+		container_of(ref, struct vspm_if_tmpl_t, ref);
 
-	/* copy */
-	if (copy_from_user(
-			&compat_vir,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_bld_vir_t))) {
-		EPRINT("failed to copy of vsp_bld_vir_t\n");
-		return -EFAULT;
-	}
-
-	/* set */
-	vir->width = compat_vir.width;
-	vir->height = compat_vir.height;
-	vir->x_position = compat_vir.x_position;
-	vir->y_position = compat_vir.y_position;
-	vir->pwd = compat_vir.pwd;
-	vir->color = (unsigned long)compat_vir.color;
+	if (tmpl->entry_data.job.type == VSPM_TYPE_VSP_AUTO)
+		free_vsp_par(&tmpl->entry_data.ip_par.vsp);
+	kfree(tmpl);
+}
 
-	return 0;
+void put_tmpl(struct vspm_if_tmpl_t *tmpl)
+{
+	if (tmpl)
+		kref_put(&tmpl->ref, release_tmpl);
 }
 
-static int set_compat_vsp_bru_par(
-	struct vspm_entry_vsp_bru *bru, unsigned int src)
+void release_all_tmpl(struct vspm_if_private_t *priv)
 {
-	struct vsp_bld_ctrl_t **src_blend[5];
-	struct compat_vsp_bru_t compat_bru;
-	int ercd;
-	int i;
+	struct vspm_if_tmpl_t *tmpl;
+	int id;
+
+	mutex_lock(&priv->tmpl_lock);
+	idr_for_each_entry(&priv->tmpl_idr, tmpl, id)
+		put_tmpl(tmpl);
+	idr_destroy(&priv->tmpl_idr);
+	mutex_unlock(&priv->tmpl_lock);
+}
 
-	/* copy vsp_bru_t parameter */
-	if (copy_from_user(
-			&compat_bru,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_bru_t))) {
-		EPRINT("failed to copy of vsp_bru_t\n");
-		return -EFAULT;
-	}
+/* objects released from callback are freed in process context */
+static LIST_HEAD(tbl_free_list);
+static LIST_HEAD(buf_table_free_list);
+static DEFINE_SPINLOCK(deferred_free_lock);
 
-	bru->bru.lay_order = (unsigned long)compat_bru.lay_order;
-	bru->bru.adiv = compat_bru.adiv;
-	bru->bru.connect = (unsigned long)compat_bru.connect;
+static void free_deferred_work(struct work_struct *work)
+{
+	struct vspm_if_tbl_t *tbl;
+	struct vspm_if_tbl_t *next;
+	struct vspm_if_buf_table_t *table;
+	struct vspm_if_buf_table_t *next_table;
+	unsigned long lock_flag;
+	unsigned int i;
+	LIST_HEAD(list);
+	LIST_HEAD(table_list);
 
-	/* copy vsp_bld_dither_t parameter */
-	for (i = 0; i < 5; i++) {
-		if (compat_bru.dither_unit[i]) {
-			if (copy_from_user(
-					&bru->dither_unit[i],
-					VSPM_IF_INT_TO_UP(
-						compat_bru.dither_unit[i]),
-					sizeof(struct vsp_bld_dither_t))) {
-				EPRINT("failed to copy of vsp_bld_dither_t\n");
-				return -EFAULT;
-			}
-			bru->bru.dither_unit[i] = &bru->dither_unit[i];
-		}
+	spin_lock_irqsave(&deferred_free_lock, lock_flag);
+	list_splice_init(&tbl_free_list, &list);
+	list_splice_init(&buf_table_free_list, &table_list);
+	spin_unlock_irqrestore(&deferred_free_lock, lock_flag);
+
+	/* tables allocated directly */
+	list_for_each_entry_safe(tbl, next, &list, list) {
+		dma_free_coherent(
+			&g_vspmif_pdev->dev,
+			tbl->size,
+			tbl->virt_addr,
+			tbl->hard_addr);
+		kfree(tbl);
 	}
 
-	/* copy vsp_bld_vir_t parameter */
-	if (compat_bru.blend_virtual) {
-		ercd = set_compat_vsp_bru_vir_par(
-			&bru->blend_virtual, compat_bru.blend_virtual);
-		if (ercd)
-			return ercd;
-		bru->bru.blend_virtual = &bru->blend_virtual;
+	/* fixed buffer tables */
+	list_for_each_entry_safe(table, next_table, &table_list, list) {
+		for (i = 0; i < table->num; i++) {
+			if (table->buf[i])
+				release_dmabuf(table->buf[i]);
+		}
+		kfree(table);
 	}
+}
 
-	/* copy vsp_bld_ctrl_t parameter */
-	src_blend[0] = &bru->bru.blend_unit_a;
-	src_blend[1] = &bru->bru.blend_unit_b;
-	src_blend[2] = &bru->bru.blend_unit_c;
-	src_blend[3] = &bru->bru.blend_unit_d;
-	src_blend[4] = &bru->bru.blend_unit_e;
+static DECLARE_WORK(deferred_free_work, free_deferred_work);
 
-	for (i = 0; i < 5; i++) {
-		if (compat_bru.blend_unit[i]) {
-			if (copy_from_user(
-					&bru->blend_unit[i],
-				    VSPM_IF_INT_TO_UP(compat_bru.blend_unit[i]),
-					sizeof(struct vsp_bld_ctrl_t))) {
-				EPRINT("failed to copy of vsp_bld_ctrl_t\n");
-				return -EFAULT;
-			}
-			*src_blend[i] = &bru->blend_unit[i];
+void flush_deferred_free(void)
+{
+	flush_work(&deferred_free_work);
+}
+
+struct vspm_if_tbl_t *alloc_tbl(
+	const void __user *tbl_addr, unsigned int tbl_num)
+{
+	struct vspm_if_tbl_t *tbl;
+
+	tbl = kzalloc(sizeof(struct vspm_if_tbl_t), GFP_KERNEL);
+	if (!tbl)
+		return ERR_PTR(-ENOMEM);
+	kref_init(&tbl->ref);
+	tbl->tbl_num = (unsigned short)tbl_num;
+	tbl->size = tbl_num * 8;
+
+	/* assign memory */
+	if (tbl->size <= VSPM_IF_RPF_CLUT_SIZE) {
+		/* memory of CLUT size class */
+		tbl->mem = get_work_mem(VSPM_IF_MEM_CLUT);
+		if (tbl->mem) {
+			tbl->virt_addr = tbl->mem->virt_addr;
+			tbl->hard_addr = tbl->mem->hard_addr;
 		}
+	} else {
+		/* LUT and CLU tables */
+		tbl->virt_addr = dma_alloc_coherent(
+			&g_vspmif_pdev->dev,
+			tbl->size,
+			&tbl->hard_addr,
+			GFP_KERNEL);
+	}
+	if (!tbl->virt_addr) {
+		EPRINT("failed to allocate table memory\n");
+		kfree(tbl);
+		return ERR_PTR(-ENOMEM);
 	}
 
-	/* copy vsp_bld_rop_t parameter */
-	if (compat_bru.rop_unit) {
-		if (copy_from_user(
-				&bru->rop_unit,
-				VSPM_IF_INT_TO_UP(compat_bru.rop_unit),
-				sizeof(struct vsp_bld_rop_t))) {
-			EPRINT("failed to copy of vsp_bld_rop_t\n");
-			return -EFAULT;
-		}
-		bru->bru.rop_unit = &bru->rop_unit;
+	/* copy table */
+	if (copy_from_user(tbl->virt_addr, tbl_addr, tbl->size)) {
+		EPRINT("failed to copy table\n");
+		put_tbl(tbl);
+		return ERR_PTR(-EFAULT);
 	}
 
-	return 0;
+	return tbl;
 }
 
-static int set_compat_vsp_hgo_par(
-	struct vspm_entry_vsp_hgo *hgo,
-	unsigned int src,
-	struct vspm_if_work_buff_t *work_buff)
+static void release_tbl(struct kref *ref)
 {
-	struct compat_vsp_hgo_t compat_hgo;
-	unsigned long tmp_addr;
+	struct vspm_if_tbl_t *tbl =
+		container_of(ref, struct vspm_if_tbl_t, ref);
+	unsigned long lock_flag;
 
-	/* copy */
-	if (copy_from_user(
-			&compat_hgo,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_hgo_t))) {
-		EPRINT("failed to copy of vsp_hgo_t\n");
-		return -EFAULT;
+	if (tbl->mem) {
+		put_work_mem(tbl->mem);
+		kfree(tbl);
+		return;
 	}
 
-	/* set */
-	tmp_addr =
-		(unsigned long)work_buff->hard_addr +
-		(unsigned long)work_buff->offset;
-	hgo->hgo.hard_addr = (unsigned int)tmp_addr;
-	tmp_addr =
-		(unsigned long)work_buff->virt_addr +
-		(unsigned long)work_buff->offset;
-	hgo->hgo.virt_addr = (void *)tmp_addr;
-
-	hgo->hgo.width = compat_hgo.width;
-	hgo->hgo.height = compat_hgo.height;
-	hgo->hgo.x_offset = compat_hgo.x_offset;
-	hgo->hgo.y_offset = compat_hgo.y_offset;
-	hgo->hgo.binary_mode = compat_hgo.binary_mode;
-	hgo->hgo.maxrgb_mode = compat_hgo.maxrgb_mode;
-	hgo->hgo.step_mode = compat_hgo.step_mode;
-	hgo->hgo.x_skip = compat_hgo.x_skip;
-	hgo->hgo.y_skip = compat_hgo.y_skip;
-	hgo->hgo.sampling = (unsigned long)compat_hgo.sampling;
-
-	hgo->user_addr = VSPM_IF_INT_TO_VP(compat_hgo.virt_addr);
+	/* this may be called from callback, so memory is freed later */
+	spin_lock_irqsave(&deferred_free_lock, lock_flag);
+	list_add_tail(&tbl->list, &tbl_free_list);
+	spin_unlock_irqrestore(&deferred_free_lock, lock_flag);
+	schedule_work(&deferred_free_work);
+}
 
-	/* increment memory offset */
-	work_buff->offset += VSPM_IF_HGO_SIZE;
+void put_tbl(struct vspm_if_tbl_t *tbl)
+{
+	if (tbl)
+		kref_put(&tbl->ref, release_tbl);
+}
 
-	return 0;
+void release_all_tbl(struct vspm_if_private_t *priv)
+{
+	struct vspm_if_tbl_t *tbl;
+	int id;
+
+	mutex_lock(&priv->tbl_lock);
+	idr_for_each_entry(&priv->tbl_idr, tbl, id)
+		put_tbl(tbl);
+	idr_destroy(&priv->tbl_idr);
+	priv->table_num = 0;
+	mutex_unlock(&priv->tbl_lock);
 }
 
-static int set_compat_vsp_hgt_par(
-	struct vspm_entry_vsp_hgt *hgt,
-	unsigned int src,
-	struct vspm_if_work_buff_t *work_buff)
+struct vspm_if_dmabuf_t *import_dmabuf(struct dma_buf *dmabuf)
 {
-	struct compat_vsp_hgt_t compat_hgt;
-	unsigned long tmp_addr;
+	struct vspm_if_dmabuf_t *buf;
+	int ercd;
 
-	int i;
+	buf = kzalloc(sizeof(struct vspm_if_dmabuf_t), GFP_KERNEL);
+	if (!buf)
+		return ERR_PTR(-ENOMEM);
 
-	/* copy */
-	if (copy_from_user(
-			&compat_hgt,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_hgt_t))) {
-		EPRINT("failed to copy of vsp_hgt_t\n");
-		return -EFAULT;
+	/* attach */
+	buf->attach = dma_buf_attach(dmabuf, &g_vspmif_pdev->dev);
+	if (IS_ERR(buf->attach)) {
+		EPRINT("failed to attach dma-buf\n");
+		ercd = PTR_ERR(buf->attach);
+		goto err_exit;
 	}
 
-	/* set */
-	tmp_addr =
-		(unsigned long)work_buff->hard_addr +
-		(unsigned long)work_buff->offset;
-	hgt->hgt.hard_addr = (unsigned int)tmp_addr;
-	tmp_addr =
-		(unsigned long)work_buff->virt_addr +
-		(unsigned long)work_buff->offset;
-	hgt->hgt.virt_addr = (void *)tmp_addr;
+	/* map */
+	buf->sgt = dma_buf_map_attachment(buf->attach, DMA_BIDIRECTIONAL);
+	if (IS_ERR(buf->sgt)) {
+		EPRINT("failed to map dma-buf\n");
+		ercd = PTR_ERR(buf->sgt);
+		goto err_exit2;
+	}
 
-	hgt->hgt.width = compat_hgt.width;
-	hgt->hgt.height = compat_hgt.height;
-	hgt->hgt.x_offset = compat_hgt.x_offset;
-	hgt->hgt.y_offset = compat_hgt.y_offset;
-	hgt->hgt.x_skip = compat_hgt.x_skip;
-	hgt->hgt.y_skip = compat_hgt.y_skip;
-	for (i = 0; i < 6; i++) {
-		hgt->hgt.area[i].lower = compat_hgt.area[i].lower;
-		hgt->hgt.area[i].upper = compat_hgt.area[i].upper;
+	/* VSP needs one contiguous area that fits the address registers */
+	buf->addr = sg_dma_address(buf->sgt->sgl);
+	if (buf->sgt->nents != 1 ||
+	    upper_32_bits(buf->addr + dmabuf->size - 1)) {
+		EPRINT("dma-buf is not contiguous for the device\n");
+		ercd = -EINVAL;
+		goto err_exit3;
 	}
-	hgt->hgt.sampling = (unsigned long)compat_hgt.sampling;
 
-	hgt->user_addr = VSPM_IF_INT_TO_VP(compat_hgt.virt_addr);
+	get_dma_buf(dmabuf);
+	buf->dmabuf = dmabuf;
+	buf->ref = 1;
 
-	/* increment memory offset */
-	work_buff->offset += VSPM_IF_HGT_SIZE;
+	return buf;
 
-	return 0;
+err_exit3:
+	dma_buf_unmap_attachment(buf->attach, buf->sgt, DMA_BIDIRECTIONAL);
+err_exit2:
+	dma_buf_detach(dmabuf, buf->attach);
+err_exit:
+	kfree(buf);
+	return ERR_PTR(ercd);
 }
 
-static int set_compat_vsp_shp_par(struct vsp_shp_t *shp, unsigned int src)
+void release_dmabuf(struct vspm_if_dmabuf_t *buf)
 {
-	struct compat_vsp_shp_t compat_shp;
+	dma_buf_unmap_attachment(buf->attach, buf->sgt, DMA_BIDIRECTIONAL);
+	dma_buf_detach(buf->dmabuf, buf->attach);
+	dma_buf_put(buf->dmabuf);
+	kfree(buf);
+}
 
-	/* copy */
-	if (copy_from_user(
-			&compat_shp,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_shp_t))) {
-		EPRINT("failed to copy of vsp_shp_t\n");
-		return -EFAULT;
-	}
+int retire_after_jobs(
+	struct vspm_if_private_t *priv, unsigned long long *seq, int counted)
+{
+	unsigned long lock_flag;
+	int busy;
 
-	/* set */
-	shp->mode = compat_shp.mode;
-	shp->gain0 = compat_shp.gain0;
-	shp->limit0 = compat_shp.limit0;
-	shp->gain10 = compat_shp.gain10;
-	shp->limit10 = compat_shp.limit10;
-	shp->gain11 = compat_shp.gain11;
-	shp->limit11 = compat_shp.limit11;
-	shp->gain20 = compat_shp.gain20;
-	shp->limit20 = compat_shp.limit20;
-	shp->gain21 = compat_shp.gain21;
-	shp->limit21 = compat_shp.limit21;
-	shp->fxa = compat_shp.fxa;
-	shp->connect = (unsigned long)compat_shp.connect;
+	/* the object is released when the jobs entried so far are done */
+	/* (counted is set if the object already waits for older jobs) */
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	*seq = priv->job_seq;
+	busy = !list_empty(&priv->entry_data.list);
+	if (busy && !counted)
+		priv->retire_num++;
+	else if (!busy && counted)
+		priv->retire_num--;
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
 
-	return 0;
+	return busy;
 }
 
-static int set_compat_vsp_ctrl_par(
-	struct vspm_entry_vsp_ctrl *ctrl,
-	unsigned int src,
-	struct vspm_if_work_buff_t *work_buff)
+void release_retired_work(struct work_struct *work)
 {
-	struct compat_vsp_ctrl_t compat_vsp_ctrl;
-	int ercd;
+	struct vspm_if_private_t *priv =
+		container_of(work, struct vspm_if_private_t, retire_work);
+	struct vspm_if_dmabuf_t *buf;
+	struct vspm_if_dmabuf_t *next;
+	struct vspm_if_uptr_t *uptr;
+	struct vspm_if_uptr_t *next_uptr;
+
+	unsigned long long done;
+	unsigned long lock_flag;
+	unsigned int num = 0;
 
-	/* copy vsp_ctrl_t parameter */
-	if (copy_from_user(
-			&compat_vsp_ctrl,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_ctrl_t))) {
-		EPRINT("failed to copy of vsp_ctrl_t\n");
-		return -EFAULT;
-	}
+	/* the jobs before the oldest one in flight are done */
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	if (list_empty(&priv->entry_data.list))
+		done = priv->job_seq;
+	else
+		done = list_first_entry(
+			&priv->entry_data.list,
+			struct vspm_if_entry_data_t, list)->seq;
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
 
-	/* copy vsp_sru_t parameter */
-	if (compat_vsp_ctrl.sru) {
-		ercd = set_compat_vsp_sru_par(&ctrl->sru, compat_vsp_ctrl.sru);
-		if (ercd)
-			return ercd;
-		ctrl->ctrl.sru = &ctrl->sru;
+	mutex_lock(&priv->dmabuf_lock);
+	list_for_each_entry_safe(buf, next, &priv->dmabuf_retire, list) {
+		if (buf->seq > done)
+			continue;
+		list_del(&buf->list);
+		release_dmabuf(buf);
+		num++;
+	}
+	mutex_unlock(&priv->dmabuf_lock);
+
+	mutex_lock(&priv->uptr_lock);
+	/* make the result of device visible to CPU */
+	list_for_each_entry(uptr, &priv->uptr_lru, list) {
+		if (!uptr->pending || uptr->seq > done)
+			continue;
+		dma_sync_sg_for_cpu(
+			&g_vspmif_pdev->dev,
+			uptr->sgt.sgl,
+			uptr->sgt.orig_nents,
+			DMA_BIDIRECTIONAL);
+		uptr->pending = 0;
+		num++;
 	}
-
-	/* copy vsp_uds_t parameter */
-	if (compat_vsp_ctrl.uds) {
-		ercd = set_compat_vsp_uds_par(&ctrl->uds, compat_vsp_ctrl.uds);
-		if (ercd)
-			return ercd;
-		ctrl->ctrl.uds = &ctrl->uds;
+	/* unpin evicted mappings (unmap also syncs for CPU) */
+	list_for_each_entry_safe(
+		uptr, next_uptr, &priv->uptr_retire, list) {
+		if (uptr->seq > done)
+			continue;
+		list_del(&uptr->list);
+		release_uptr(uptr);
+		num++;
 	}
+	mutex_unlock(&priv->uptr_lock);
 
-	/* copy vsp_lut_t parameter */
-	if (compat_vsp_ctrl.lut) {
-		ercd = set_compat_vsp_lut_par(&ctrl->lut, compat_vsp_ctrl.lut);
-		if (ercd)
-			return ercd;
-		ctrl->ctrl.lut = &ctrl->lut;
-	}
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	priv->retire_num -= num;
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+}
 
-	/* copy vsp_clu_t parameter */
-	if (compat_vsp_ctrl.clu) {
-		ercd = set_compat_vsp_clu_par(&ctrl->clu, compat_vsp_ctrl.clu);
-		if (ercd)
-			return ercd;
-		ctrl->ctrl.clu = &ctrl->clu;
-	}
+void release_all_dmabuf(struct vspm_if_private_t *priv)
+{
+	struct vspm_if_dmabuf_t *buf;
+	struct vspm_if_dmabuf_t *next;
+	int id;
+
+	/* called after vspm_quit_driver(), no job is using the buffers */
+	cancel_work_sync(&priv->retire_work);
+
+	mutex_lock(&priv->dmabuf_lock);
+	idr_for_each_entry(&priv->dmabuf_idr, buf, id)
+		release_dmabuf(buf);
+	list_for_each_entry_safe(buf, next, &priv->dmabuf_retire, list) {
+		list_del(&buf->list);
+		release_dmabuf(buf);
+	}
+	idr_destroy(&priv->dmabuf_idr);
+	priv->dmabuf_num = 0;
+	put_buf_table(priv->buf_table);
+	priv->buf_table = NULL;
+	mutex_unlock(&priv->dmabuf_lock);
+}
 
-	/* copy vsp_hst_t parameter */
-	if (compat_vsp_ctrl.hst) {
-		ercd = set_compat_vsp_hst_par(&ctrl->hst, compat_vsp_ctrl.hst);
-		if (ercd)
-			return ercd;
-		ctrl->ctrl.hst = &ctrl->hst;
-	}
+struct vspm_if_buf_table_t *alloc_buf_table(
+	const int __user *fds, unsigned int num)
+{
+	struct vspm_if_buf_table_t *table;
+	struct dma_buf *dmabuf;
+	unsigned int i;
+	int fd;
+
+	table = kzalloc(
+		sizeof(struct vspm_if_buf_table_t) +
+		num * sizeof(struct vspm_if_dmabuf_t *),
+		GFP_KERNEL);
+	if (!table)
+		return ERR_PTR(-ENOMEM);
+	kref_init(&table->ref);
+	table->num = num;
+
+	/* attach and map all buffers at once */
+	for (i = 0; i < num; i++) {
+		if (get_user(fd, &fds[i])) {
+			table->buf[i] = ERR_PTR(-EFAULT);
+			goto err_exit;
+		}
 
-	/* copy vsp_hsi_t parameter */
-	if (compat_vsp_ctrl.hsi) {
-		ercd = set_compat_vsp_hsi_par(&ctrl->hsi, compat_vsp_ctrl.hsi);
-		if (ercd)
-			return ercd;
-		ctrl->ctrl.hsi = &ctrl->hsi;
-	}
+		/* -1 means empty entry */
+		if (fd < 0)
+			continue;
 
-	/* copy vsp_bru_t parameter */
-	if (compat_vsp_ctrl.bru) {
-		ercd = set_compat_vsp_bru_par(&ctrl->bru, compat_vsp_ctrl.bru);
-		if (ercd)
-			return ercd;
-		ctrl->ctrl.bru = &ctrl->bru.bru;
+		dmabuf = dma_buf_get(fd);
+		if (IS_ERR(dmabuf)) {
+			table->buf[i] = ERR_CAST(dmabuf);
+			goto err_exit;
+		}
+		table->buf[i] = import_dmabuf(dmabuf);
+		dma_buf_put(dmabuf);
+		if (IS_ERR(table->buf[i]))
+			goto err_exit;
 	}
 
-	/* copy vsp_hgo_t parameter */
-	if (compat_vsp_ctrl.hgo) {
-		ercd = set_compat_vsp_hgo_par(
-			&ctrl->hgo, compat_vsp_ctrl.hgo, work_buff);
-		if (ercd)
-			return ercd;
-		ctrl->ctrl.hgo = &ctrl->hgo.hgo;
-	}
+	return table;
+
+err_exit:
+	dmabuf = ERR_CAST(table->buf[i]);
+	table->buf[i] = NULL;
+	while (i--) {
+		if (table->buf[i])
+			release_dmabuf(table->buf[i]);
+	}
+	kfree(table);
+	return ERR_CAST(dmabuf);
+}
+
+static void release_buf_table(struct kref *ref)
+{
+	struct vspm_if_buf_table_t *table =
+		container_of(ref, struct vspm_if_buf_table_t, ref);
+	unsigned long lock_flag;
+
+	/* this may be called from callback, so buffers are released later */
+	spin_lock_irqsave(&deferred_free_lock, lock_flag);
+	list_add_tail(&table->list, &buf_table_free_list);
+	spin_unlock_irqrestore(&deferred_free_lock, lock_flag);
+	schedule_work(&deferred_free_work);
+}
+
+void put_buf_table(struct vspm_if_buf_table_t *table)
+{
+	if (table)
+		kref_put(&table->ref, release_buf_table);
+}
+
+int set_fixed_buf_addr(
+	const struct vspm_if_buf_table_t *table,
+	unsigned int index,
+	struct vspm_if_tmpl_addr_t *addr,
+	const struct vspm_if_plane_size_t *plane)
+{
+	const struct vspm_if_dmabuf_t *buf;
+	unsigned long long size;
+
+	if (index >= table->num || !table->buf[index])
+		return -EINVAL;
+	buf = table->buf[index];
+	size = buf->dmabuf->size;
+
+	/* offsets from the head of the buffer, the planes must fit in */
+	if ((unsigned long long)addr->addr + plane->size > size ||
+	    (unsigned long long)addr->addr_c0 + plane->size_c > size ||
+	    (unsigned long long)addr->addr_c1 + plane->size_c > size)
+		return -EINVAL;
+
+	addr->addr = VSPM_IF_DMA_TO_INT(buf->addr + addr->addr);
+	addr->addr_c0 = VSPM_IF_DMA_TO_INT(buf->addr + addr->addr_c0);
+	addr->addr_c1 = VSPM_IF_DMA_TO_INT(buf->addr + addr->addr_c1);
+
+	return 0;
+}
 
-	/* copy vsp_hgt_t parameter */
-	if (compat_vsp_ctrl.hgt) {
-		ercd = set_compat_vsp_hgt_par(
-			&ctrl->hgt, compat_vsp_ctrl.hgt, work_buff);
-		if (ercd)
-			return ercd;
-		ctrl->ctrl.hgt = &ctrl->hgt.hgt;
+static struct sg_table *map_export_buf(
+	struct dma_buf_attachment *attach, enum dma_data_direction dir)
+{
+	struct vspm_if_export_buf_t *buf = attach->dmabuf->priv;
+	struct sg_table *sgt;
+
+	sgt = kmalloc(sizeof(struct sg_table), GFP_KERNEL);
+	if (!sgt)
+		return ERR_PTR(-ENOMEM);
+
+	/* the buffer is physically contiguous */
+	if (sg_alloc_table(sgt, 1, GFP_KERNEL)) {
+		kfree(sgt);
+		return ERR_PTR(-ENOMEM);
 	}
+	sg_set_page(sgt->sgl, virt_to_page(buf->virt_addr), buf->size, 0);
 
-	/* copy vsp_shp_t parameter */
-	if (compat_vsp_ctrl.shp) {
-		ercd = set_compat_vsp_shp_par(&ctrl->shp, compat_vsp_ctrl.shp);
-		if (ercd)
-			return ercd;
-		ctrl->ctrl.shp = &ctrl->shp;
+	if (!dma_map_sg(attach->dev, sgt->sgl, 1, dir)) {
+		sg_free_table(sgt);
+		kfree(sgt);
+		return ERR_PTR(-ENOMEM);
 	}
 
+	return sgt;
+}
+
+static void unmap_export_buf(
+	struct dma_buf_attachment *attach,
+	struct sg_table *sgt,
+	enum dma_data_direction dir)
+{
+	dma_unmap_sg(attach->dev, sgt->sgl, 1, dir);
+	sg_free_table(sgt);
+	kfree(sgt);
+}
+
+static int begin_cpu_access_export_buf(
+	struct dma_buf *dmabuf, enum dma_data_direction dir)
+{
+	struct vspm_if_export_buf_t *buf = dmabuf->priv;
+
+	dma_sync_single_for_cpu(
+		&g_vspmif_pdev->dev, buf->hard_addr, buf->size, dir);
 	return 0;
 }
 
-int set_compat_vsp_par(
-	struct vspm_if_entry_data_t *entry, unsigned int src)
+static int end_cpu_access_export_buf(
+	struct dma_buf *dmabuf, enum dma_data_direction dir)
 {
-	struct vspm_entry_vsp *vsp = &entry->ip_par.vsp;
-	struct compat_vsp_start_t compat_vsp_par;
-	unsigned long tmp_addr;
+	struct vspm_if_export_buf_t *buf = dmabuf->priv;
 
-	int ercd;
+	dma_sync_single_for_device(
+		&g_vspmif_pdev->dev, buf->hard_addr, buf->size, dir);
+	return 0;
+}
 
-	int i;
+static int mmap_export_buf(struct dma_buf *dmabuf, struct vm_area_struct *vma)
+{
+	struct vspm_if_export_buf_t *buf = dmabuf->priv;
+	unsigned long size = vma->vm_end - vma->vm_start;
+	unsigned long pfn = page_to_pfn(virt_to_page(buf->virt_addr));
+
+	if (vma->vm_pgoff >= PAGE_ALIGN(buf->size) >> PAGE_SHIFT ||
+	    size > PAGE_ALIGN(buf->size) - (vma->vm_pgoff << PAGE_SHIFT))
+		return -EINVAL;
+
+	/* cached mapping, synchronized by DMA_BUF_IOCTL_SYNC */
+	return remap_pfn_range(
+		vma, vma->vm_start, pfn + vma->vm_pgoff, size,
+		vma->vm_page_prot);
+}
 
-	/* copy vsp_start_t parameter */
-	if (copy_from_user(
-			&compat_vsp_par,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_vsp_start_t))) {
-		EPRINT("failed to copy of vsp_start_t\n");
-		return -EFAULT;
-	}
+static void free_export_buf(struct vspm_if_export_buf_t *buf)
+{
+	dma_free_noncoherent(
+		&g_vspmif_pdev->dev,
+		buf->size,
+		buf->virt_addr,
+		buf->hard_addr,
+		DMA_BIDIRECTIONAL);
+	kfree(buf);
+}
 
-	vsp->par.rpf_num = compat_vsp_par.rpf_num;
-	vsp->par.rpf_order = 0;	/* not used */
-	vsp->par.use_module = (unsigned long)compat_vsp_par.use_module;
+static void release_export_buf(struct dma_buf *dmabuf)
+{
+	free_export_buf(dmabuf->priv);
+}
 
-	/* get work buffer */
-	vsp->work_buff = get_work_buffer(entry->priv);
-	if (!vsp->work_buff)
-		return -EFAULT;
+static const struct dma_buf_ops export_buf_ops = {
+	.map_dma_buf = map_export_buf,
+	.unmap_dma_buf = unmap_export_buf,
+	.release = release_export_buf,
+	.begin_cpu_access = begin_cpu_access_export_buf,
+	.end_cpu_access = end_cpu_access_export_buf,
+	.mmap = mmap_export_buf,
+};
 
-	/* copy vsp_src_t parameter */
-	for (i = 0; i < 5; i++) {
-		if (compat_vsp_par.src_par[i]) {
-			ercd = set_compat_vsp_src_par(
-				&vsp->in[i],
-				compat_vsp_par.src_par[i],
-				vsp->work_buff);
-			if (ercd)
-				goto err_exit;
-			vsp->par.src_par[i] = &vsp->in[i].in;
-		}
-	}
+struct dma_buf *alloc_export_buf(size_t size)
+{
+	DEFINE_DMA_BUF_EXPORT_INFO(exp_info);
+	struct vspm_if_export_buf_t *buf;
+	struct dma_buf *dmabuf;
 
-	/* copy vsp_dst_t parameter */
-	if (compat_vsp_par.dst_par) {
-		ercd = set_compat_vsp_dst_par(
-			&vsp->out, compat_vsp_par.dst_par);
-		if (ercd)
-			goto err_exit;
-		vsp->par.dst_par = &vsp->out.out;
-	}
+	buf = kzalloc(sizeof(struct vspm_if_export_buf_t), GFP_KERNEL);
+	if (!buf)
+		return ERR_PTR(-ENOMEM);
+	buf->size = size;
 
-	/* copy vsp_ctrl_t parameter */
-	if (compat_vsp_par.ctrl_par) {
-		ercd = set_compat_vsp_ctrl_par(
-			&vsp->ctrl, compat_vsp_par.ctrl_par, vsp->work_buff);
-		if (ercd)
-			goto err_exit;
-		vsp->par.ctrl_par = &vsp->ctrl.ctrl;
+	/* contiguous memory that is cached by CPU */
+	buf->virt_addr = dma_alloc_noncoherent(
+		&g_vspmif_pdev->dev,
+		size,
+		&buf->hard_addr,
+		DMA_BIDIRECTIONAL,
+		GFP_KERNEL);
+	if (!buf->virt_addr) {
+		EPRINT("failed to allocate image buffer\n");
+		kfree(buf);
+		return ERR_PTR(-ENOMEM);
 	}
 
-	/* assign memory for display list */
-	tmp_addr =
-		(unsigned long)vsp->work_buff->hard_addr +
-		(unsigned long)vsp->work_buff->offset;
-	vsp->par.dl_par.hard_addr = (unsigned int)tmp_addr;
-	tmp_addr =
-		(unsigned long)vsp->work_buff->virt_addr +
-		(unsigned long)vsp->work_buff->offset;
-	vsp->par.dl_par.virt_addr = (void *)tmp_addr;
-	vsp->par.dl_par.tbl_num =
-		(VSPM_IF_MEM_SIZE - vsp->work_buff->offset) >> 3;
+	/* export */
+	exp_info.ops = &export_buf_ops;
+	exp_info.size = size;
+	exp_info.flags = O_RDWR;
+	exp_info.priv = buf;
 
-	return 0;
+	dmabuf = dma_buf_export(&exp_info);
+	if (IS_ERR(dmabuf))
+		free_export_buf(buf);
 
-err_exit:
-	free_vsp_par(vsp);
-	return ercd;
+	return dmabuf;
 }
 
-static int set_compat_fdp_pic_par(struct fdp_pic_t *in_pic, unsigned int src)
+struct vspm_if_uptr_t *alloc_uptr(unsigned long user_addr, unsigned int size)
 {
-	struct compat_fdp_pic_t compat_fdp_pic;
-
-	/* copy */
-	if (copy_from_user(
-			&compat_fdp_pic,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_fdp_pic_t))) {
-		EPRINT("failed to copy of fdp_pic_t\n");
-		return -EFAULT;
-	}
+	struct vspm_if_uptr_t *uptr;
+	unsigned int offset = offset_in_page(user_addr);
+	int pinned;
+	int ercd;
 
-	/* set */
-	in_pic->picid = (unsigned long)compat_fdp_pic.picid;
-	in_pic->chroma_format = compat_fdp_pic.chroma_format;
-	in_pic->width = compat_fdp_pic.width;
-	in_pic->height = compat_fdp_pic.height;
-	in_pic->progressive_sequence = compat_fdp_pic.progressive_sequence;
-	in_pic->progressive_frame = compat_fdp_pic.progressive_frame;
-	in_pic->picture_structure = compat_fdp_pic.picture_structure;
-	in_pic->repeat_first_field = compat_fdp_pic.repeat_first_field;
-	in_pic->top_field_first = compat_fdp_pic.top_field_first;
+	uptr = kzalloc(sizeof(struct vspm_if_uptr_t), GFP_KERNEL);
+	if (!uptr)
+		return ERR_PTR(-ENOMEM);
+	uptr->user_addr = user_addr;
+	uptr->size = size;
+	uptr->npages = PAGE_ALIGN(offset + size) >> PAGE_SHIFT;
+
+	uptr->pages = kvmalloc(
+		uptr->npages * sizeof(struct page *), GFP_KERNEL);
+	if (!uptr->pages) {
+		ercd = -ENOMEM;
+		goto err_exit;
+	}
+
+	/* pin user pages (moved out of CMA if necessary) */
+	pinned = pin_user_pages_fast(
+		user_addr & PAGE_MASK,
+		uptr->npages,
+		FOLL_WRITE | FOLL_LONGTERM,
+		uptr->pages);
+	if (pinned != uptr->npages) {
+		EPRINT("failed to pin user pages\n");
+		if (pinned > 0)
+			unpin_user_pages(uptr->pages, pinned);
+		ercd = pinned < 0 ? pinned : -EFAULT;
+		goto err_exit2;
+	}
+
+	/* map for the device */
+	ercd = sg_alloc_table_from_pages(
+		&uptr->sgt, uptr->pages, uptr->npages, offset, size,
+		GFP_KERNEL);
+	if (ercd)
+		goto err_exit3;
+
+	if (dma_map_sg(&g_vspmif_pdev->dev, uptr->sgt.sgl,
+		       uptr->sgt.orig_nents, DMA_BIDIRECTIONAL) != 1) {
+		EPRINT("user pages are not contiguous for the device\n");
+		ercd = -EINVAL;
+		goto err_exit4;
+	}
+	uptr->sgt.nents = 1;
+	uptr->addr = sg_dma_address(uptr->sgt.sgl);
+
+	uptr->mm = current->mm;
+	mmgrab(uptr->mm);
+
+	return uptr;
+
+err_exit4:
+	dma_unmap_sg(&g_vspmif_pdev->dev, uptr->sgt.sgl,
+		     uptr->sgt.orig_nents, DMA_BIDIRECTIONAL);
+	sg_free_table(&uptr->sgt);
+err_exit3:
+	unpin_user_pages(uptr->pages, uptr->npages);
+err_exit2:
+	kvfree(uptr->pages);
+err_exit:
+	kfree(uptr);
+	return ERR_PTR(ercd);
+}
 
-	return 0;
+void release_uptr(struct vspm_if_uptr_t *uptr)
+{
+	dma_unmap_sg(&g_vspmif_pdev->dev, uptr->sgt.sgl,
+		     uptr->sgt.orig_nents, DMA_BIDIRECTIONAL);
+	sg_free_table(&uptr->sgt);
+	unpin_user_pages(uptr->pages, uptr->npages);
+	kvfree(uptr->pages);
+	mmdrop(uptr->mm);
+	kfree(uptr);
 }
 
-static int set_compat_fdp_ref_par(
-	struct vspm_entry_fdp_ref *ref, unsigned int src)
+void release_all_uptr(struct vspm_if_private_t *priv)
 {
-	struct compat_fdp_refbuf_t compat_fdp_refbuf;
+	struct vspm_if_uptr_t *uptr;
+	struct vspm_if_uptr_t *next;
 
-	/* copy fdp_refbuf_t parameter */
-	if (copy_from_user(
-			&compat_fdp_refbuf,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_fdp_refbuf_t))) {
-		EPRINT("failed to copy of fdp_refbuf_t\n");
-		return -EFAULT;
-	}
+	/* called after vspm_quit_driver(), no job is using the pages */
+	cancel_work_sync(&priv->retire_work);
 
-	if (compat_fdp_refbuf.next_buf) {
-		if (copy_from_user(
-				&ref->ref[0],
-				VSPM_IF_INT_TO_UP(compat_fdp_refbuf.next_buf),
-				sizeof(struct fdp_imgbuf_t))) {
-			EPRINT("failed to copy to fdp_imgbuf_t\n");
-			return -EFAULT;
-		}
-		ref->ref_buf.next_buf = &ref->ref[0];
+	mutex_lock(&priv->uptr_lock);
+	list_for_each_entry_safe(uptr, next, &priv->uptr_lru, list) {
+		list_del(&uptr->list);
+		release_uptr(uptr);
 	}
-
-	if (compat_fdp_refbuf.cur_buf) {
-		if (copy_from_user(
-				&ref->ref[1],
-				VSPM_IF_INT_TO_UP(compat_fdp_refbuf.cur_buf),
-				sizeof(struct fdp_imgbuf_t))) {
-			EPRINT("failed to copy to fdp_imgbuf_t\n");
-			return -EFAULT;
-		}
-		ref->ref_buf.cur_buf = &ref->ref[1];
+	list_for_each_entry_safe(uptr, next, &priv->uptr_retire, list) {
+		list_del(&uptr->list);
+		release_uptr(uptr);
 	}
+	priv->uptr_num = 0;
+	mutex_unlock(&priv->uptr_lock);
+}
 
-	if (compat_fdp_refbuf.prev_buf) {
-		if (copy_from_user(
-				&ref->ref[2],
-				VSPM_IF_INT_TO_UP(compat_fdp_refbuf.prev_buf),
-				sizeof(struct fdp_imgbuf_t))) {
-			EPRINT("failed to copy to fdp_imgbuf_t\n");
-			return -EFAULT;
-		}
-		ref->ref_buf.prev_buf = &ref->ref[2];
-	}
+/* out-fence (the lock lives with the fence, it may outlive the fd) */
+struct vspm_if_fence_t {
+	struct dma_fence base;
+	spinlock_t lock;
+};
 
-	return 0;
+static const char *fence_get_driver_name(struct dma_fence *fence)
+{
+	return "vspm_if";
 }
 
-static int set_compat_fdp_fproc_par(
-	struct vspm_entry_fdp_fproc *fproc, unsigned int src)
+static const char *fence_get_timeline_name(struct dma_fence *fence)
 {
-	struct compat_fdp_fproc_t compat_fdp_fproc;
-	int ercd;
+	return "vspm";
+}
 
-	/* copy fdp_fproc_t parameter */
-	if (copy_from_user(
-			&compat_fdp_fproc,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_fdp_fproc_t))) {
-		EPRINT("failed to copy of fdp_fproc_t\n");
-		return -EFAULT;
-	}
+static void fence_release(struct dma_fence *fence)
+{
+	dma_fence_free(fence);
 
-	fproc->fproc.last_seq_indicator = compat_fdp_fproc.last_seq_indicator;
-	fproc->fproc.current_field = compat_fdp_fproc.current_field;
-	fproc->fproc.interpolated_line = compat_fdp_fproc.interpolated_line;
-	fproc->fproc.out_format = compat_fdp_fproc.out_format;
+	/* the ops are in this module, a sync_file may outlive the fd */
+	module_put(THIS_MODULE);
+}
 
-	/* copy fdp_seq_t parameter */
-	if (compat_fdp_fproc.seq_par) {
-		if (copy_from_user(
-				&fproc->seq,
-				VSPM_IF_INT_TO_UP(compat_fdp_fproc.seq_par),
-				sizeof(struct fdp_seq_t))) {
-			EPRINT("failed to copy to fdp_seq_t\n");
-			return -EFAULT;
-		}
-		fproc->fproc.seq_par = &fproc->seq;
-	}
+static const struct dma_fence_ops vspm_if_fence_ops = {
+	.get_driver_name = fence_get_driver_name,
+	.get_timeline_name = fence_get_timeline_name,
+	.release = fence_release,
+};
 
-	/* copy fdp_pic_t parameter */
-	if (compat_fdp_fproc.in_pic) {
-		ercd = set_compat_fdp_pic_par(
-			&fproc->in_pic, compat_fdp_fproc.in_pic);
-		if (ercd)
-			return ercd;
-		fproc->fproc.in_pic = &fproc->in_pic;
-	}
+struct dma_fence *alloc_out_fence(void)
+{
+	struct vspm_if_fence_t *fence;
 
-	/* copy fdp_imgbuf_t parameter */
-	if (compat_fdp_fproc.out_buf) {
-		if (copy_from_user(
-				&fproc->out_buf,
-				VSPM_IF_INT_TO_UP(compat_fdp_fproc.out_buf),
-				sizeof(struct fdp_imgbuf_t))) {
-			EPRINT("failed to copy to fdp_imgbuf_t\n");
-			return -EFAULT;
-		}
-		fproc->fproc.out_buf = &fproc->out_buf;
-	}
+	fence = kzalloc(sizeof(struct vspm_if_fence_t), GFP_KERNEL);
+	if (!fence)
+		return NULL;
 
-	/* copy fdp_refbuf_t parameter */
-	if (compat_fdp_fproc.ref_buf) {
-		ercd = set_compat_fdp_ref_par(
-			&fproc->ref, compat_fdp_fproc.ref_buf);
-		if (ercd)
-			return ercd;
-		fproc->fproc.ref_buf = &fproc->ref.ref_buf;
-	}
+	/* released by fence_release() */
+	__module_get(THIS_MODULE);
 
-	/* copy fcp_info_t parameter */
-	if (compat_fdp_fproc.fcp_par) {
-		if (copy_from_user(
-				&fproc->fcp,
-				VSPM_IF_INT_TO_UP(compat_fdp_fproc.fcp_par),
-				sizeof(struct fcp_info_t))) {
-			EPRINT("failed to copy to fcp_info_t\n");
-			return -EFAULT;
-		}
-		fproc->fproc.fcp_par = &fproc->fcp;
+	/* jobs complete out of order by priority, so no shared timeline */
+	spin_lock_init(&fence->lock);
+	dma_fence_init(
+		&fence->base,
+		&vspm_if_fence_ops,
+		&fence->lock,
+		dma_fence_context_alloc(1),
+		1);
+
+	return &fence->base;
+}
+
+void signal_out_fence(struct dma_fence **fence, int error)
+{
+	if (!*fence)
+		return;
+
+	if (error)
+		dma_fence_set_error(*fence, error);
+	dma_fence_signal(*fence);
+	dma_fence_put(*fence);
+	*fence = NULL;
+}
+
+struct vspm_if_in_fence_t *alloc_in_fence(
+	const int __user *fds,
+	unsigned int num,
+	struct dma_fence **deps,
+	unsigned int dep_num)
+{
+	struct vspm_if_in_fence_t *in_fence;
+	struct vspm_if_fence_wait_t *wait;
+	int fd[VSPM_IF_IN_FENCE_MAX];
+	unsigned int i;
+
+	if (num > VSPM_IF_IN_FENCE_MAX)
+		return ERR_PTR(-EINVAL);
+
+	if (num && copy_from_user(fd, fds, sizeof(int) * num)) {
+		EPRINT("failed to copy the in-fence fds\n");
+		return ERR_PTR(-EFAULT);
 	}
 
-	/* copy fdp_ipc_t parameter */
-	if (compat_fdp_fproc.ipc_par) {
-		if (copy_from_user(
-				&fproc->ipc,
-				VSPM_IF_INT_TO_UP(compat_fdp_fproc.ipc_par),
-				sizeof(struct fdp_ipc_t))) {
-			EPRINT("failed to copy to fdp_ipc_t\n");
-			return -EFAULT;
+	in_fence = kzalloc(
+		sizeof(struct vspm_if_in_fence_t) +
+		(num + dep_num) * sizeof(struct vspm_if_fence_wait_t),
+		GFP_KERNEL);
+	if (!in_fence)
+		return ERR_PTR(-ENOMEM);
+	INIT_LIST_HEAD(&in_fence->list);
+
+	/* fences of prerequisite jobs in the same graph */
+	for (i = 0; i < dep_num; i++) {
+		wait = &in_fence->wait[in_fence->num++];
+		wait->fence = dma_fence_get(deps[i]);
+		wait->in_fence = in_fence;
+	}
+
+	for (i = 0; i < num; i++) {
+		wait = &in_fence->wait[in_fence->num];
+		wait->fence = sync_file_get_fence(fd[i]);
+		if (!wait->fence) {
+			EPRINT("invalid in-fence fd %d\n", fd[i]);
+			free_in_fence(in_fence);
+			return ERR_PTR(-EINVAL);
 		}
-		fproc->fproc.ipc_par = &fproc->ipc;
+		wait->in_fence = in_fence;
+		in_fence->num++;
 	}
 
-	return 0;
+	return in_fence;
 }
 
-int set_compat_fdp_par(
-	struct vspm_if_entry_data_t *entry, unsigned int src)
+void free_in_fence(struct vspm_if_in_fence_t *in_fence)
 {
-	struct vspm_entry_fdp *fdp = &entry->ip_par.fdp;
-	struct compat_fdp_start_t compat_fdp_par;
-	int ercd;
+	unsigned int i;
 
-	/* copy fdp_start_t parameter */
-	if (copy_from_user(
-			&compat_fdp_par,
-			VSPM_IF_INT_TO_UP(src),
-			sizeof(struct compat_fdp_start_t))) {
-		EPRINT("failed to copy of fdp_start_t\n");
-		return -EFAULT;
-	}
+	for (i = 0; i < in_fence->num; i++)
+		dma_fence_put(in_fence->wait[i].fence);
+	kfree(in_fence);
+}
 
-	fdp->par.fdpgo = compat_fdp_par.fdpgo;
+void release_all_in_fence(struct vspm_if_private_t *priv)
+{
+	struct vspm_if_in_fence_t *in_fence;
+	struct vspm_if_in_fence_t *next;
+	LIST_HEAD(list);
 
-	/* copy fdp_fproc_t parameter */
-	if (compat_fdp_par.fproc_par) {
-		ercd = set_compat_fdp_fproc_par(
-			&fdp->fproc, compat_fdp_par.fproc_par);
-		if (ercd)
-			return ercd;
-		fdp->par.fproc_par = &fdp->fproc.fproc;
+	unsigned long lock_flag;
+	unsigned int i;
+
+	spin_lock_irqsave(&priv->lock, lock_flag);
+	list_splice_init(&priv->in_fence_list, &list);
+	spin_unlock_irqrestore(&priv->lock, lock_flag);
+
+	/* no callback runs after removed (or already called) */
+	list_for_each_entry(in_fence, &list, list) {
+		for (i = 0; i < in_fence->num; i++) {
+			dma_fence_remove_callback(
+				in_fence->wait[i].fence,
+				&in_fence->wait[i].cb);
+		}
 	}
 
-	return 0;
+	/* wait for the jobs being entried */
+	cancel_work_sync(&priv->fence_work);
+
+	/* entry data is released with the other entry data */
+	list_for_each_entry_safe(in_fence, next, &list, list) {
+		list_del(&in_fence->list);
+		free_in_fence(in_fence);
+	}
 }
@@ -70,10 +70,41 @@ enum {
 	VSPM_CMD_WAIT_INTERRUPT,
 	VSPM_CMD_WAIT_THREAD,
 	VSPM_CMD_STOP_THREAD,
+	VSPM_CMD_ENTRY_BATCH,
+	VSPM_CMD_ENTRY_V2,
+	VSPM_CMD_TMPL_REGISTER,
+	VSPM_CMD_TMPL_UNREGISTER,
+	VSPM_CMD_TMPL_ENTRY,
+	VSPM_CMD_SQ_SETUP,
+	VSPM_CMD_SQ_ENTER,
+	VSPM_CMD_CQ_SETUP,
+	VSPM_CMD_CQ_WAIT,
+	VSPM_CMD_WAIT_INTERRUPT_MULTI,
+	VSPM_CMD_SET_CONFIG,
+	VSPM_CMD_GET_STATS,
+	VSPM_CMD_TBL_REGISTER,
+	VSPM_CMD_TBL_UNREGISTER,
+	VSPM_CMD_DMABUF_IMPORT,
+	VSPM_CMD_DMABUF_RELEASE,
+	VSPM_CMD_BUF_REGISTER,
+	VSPM_CMD_BUF_UNREGISTER,
+	VSPM_CMD_BUF_ALLOC,
+	VSPM_CMD_USERPTR_MAP,
+	VSPM_CMD_USERPTR_UNMAP,
+	VSPM_CMD_ENTRY_FENCE,
+	VSPM_CMD_ENTRY_GRAPH,
+	VSPM_CMD_PIPE_INIT,
+	VSPM_CMD_ENTRY_PIPE,
 };
 
 #define VSPM_IOC_MAGIC 'v'
 
+/* maximum number of jobs per batch entry */
+#define VSPM_IF_ENTRY_BATCH_MAX		(32)
+
+/* maximum number of responses per WAIT_INTERRUPT_MULTI */
+#define VSPM_IF_CB_MULTI_MAX		(64)
+
 /* for 64bit */
 struct vspm_if_entry_t {
 	struct vspm_if_entry_req_t {
@@ -88,6 +119,12 @@ struct vspm_if_entry_t {
 	} rsp;
 };
 
+struct vspm_if_entry_batch_t {
+	unsigned int num;
+	unsigned int done;
+	struct vspm_if_entry_t *entry;
+};
+
 struct vspm_if_cb_rsp_t {
 	long ercd;
 	PFN_VSPM_COMPLETE_CALLBACK cb_func;
@@ -96,6 +133,12 @@ struct vspm_if_cb_rsp_t {
 	void *user_data;
 };
 
+struct vspm_if_cb_multi_t {
+	unsigned int num;
+	unsigned int done;
+	struct vspm_if_cb_rsp_t *rsp;
+};
+
 #define VSPM_IOC_CMD_INIT \
 	_IOR(VSPM_IOC_MAGIC, VSPM_CMD_INIT, struct vspm_init_t)
 #define VSPM_IOC_CMD_QUIT \
@@ -112,6 +155,14 @@ struct vspm_if_cb_rsp_t {
 	_IO(VSPM_IOC_MAGIC, VSPM_CMD_WAIT_THREAD)
 #define VSPM_IOC_CMD_STOP_THREAD \
 	_IO(VSPM_IOC_MAGIC, VSPM_CMD_STOP_THREAD)
+#define VSPM_IOC_CMD_ENTRY_BATCH \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_ENTRY_BATCH, \
+	struct vspm_if_entry_batch_t)
+#define VSPM_IOC_CMD_WAIT_INTERRUPT_MULTI \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_WAIT_INTERRUPT_MULTI, \
+	struct vspm_if_cb_multi_t)
 
 /* for 32bit */
 struct vspm_compat_init_t {
@@ -137,6 +188,12 @@ struct vspm_compat_entry_t {
 	} rsp;
 };
 
+struct vspm_compat_entry_batch_t {
+	unsigned int num;
+	unsigned int done;
+	unsigned int entry;
+};
+
 struct vspm_compat_job_t {
 	unsigned short type;
 	union {
@@ -426,6 +483,12 @@ struct vspm_compat_cb_rsp_t {
 	unsigned int user_data;
 };
 
+struct vspm_compat_cb_multi_t {
+	unsigned int num;
+	unsigned int done;
+	unsigned int rsp;
+};
+
 #define VSPM_IOC_CMD_INIT32 \
 	_IOR(VSPM_IOC_MAGIC, \
 	VSPM_CMD_INIT, \
@@ -446,5 +509,507 @@ struct vspm_compat_cb_rsp_t {
 	_IOWR(VSPM_IOC_MAGIC, \
 	VSPM_CMD_WAIT_INTERRUPT, \
 	struct vspm_compat_cb_rsp_t)
+#define VSPM_IOC_CMD_ENTRY_BATCH32 \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_ENTRY_BATCH, \
+	struct vspm_compat_entry_batch_t)
+#define VSPM_IOC_CMD_WAIT_INTERRUPT_MULTI32 \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_WAIT_INTERRUPT_MULTI, \
+	struct vspm_compat_cb_multi_t)
+
+/* for flat job descriptor (common to 32bit and 64bit) */
+#define VSPM_IF_JOB_V2_MAX_SIZE		(16384)
+
+/*
+ * The descriptor is one contiguous block that begins with
+ * struct vspm_if_job_v2_t. It uses the 32bit structures (compat_*)
+ * above, but every pointer member holds a byte offset from the head
+ * of the descriptor instead of an address (0 means not used).
+ * The color table of a CLUT (compat_vsp_dl_t.virt_addr) is also
+ * placed in the descriptor. The HGO/HGT virt_addr members are ignored,
+ * the results are copied to hgo_addr/hgt_addr of the request.
+ */
+struct vspm_if_job_v2_t {
+	struct vspm_compat_job_t job;
+};
+
+struct vspm_if_entry_v2_t {
+	struct vspm_if_entry_v2_req_t {
+		unsigned long long job_param;
+		unsigned long long user_data;
+		unsigned long long cb_func;
+		unsigned long long hgo_addr;
+		unsigned long long hgt_addr;
+		unsigned int job_size;
+		char priority;
+		unsigned char reserved[3];
+	} req;
+	struct vspm_if_entry_v2_rsp_t {
+		long long ercd;
+		unsigned long long job_id;
+	} rsp;
+};
+
+#define VSPM_IOC_CMD_ENTRY_V2 \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_ENTRY_V2, \
+	struct vspm_if_entry_v2_t)
+
+/* for job template (common to 32bit and 64bit) */
+#define VSPM_IF_TMPL_PATCH_SRC(n)	(0x0001 << (n))	/* src_par[0-4] */
+#define VSPM_IF_TMPL_PATCH_DST		(0x0020)
+#define VSPM_IF_TMPL_PATCH_FDP_OUT	(0x0040)
+#define VSPM_IF_TMPL_PATCH_FDP_REF(n)	(0x0080 << (n))	/* next/cur/prev */
+#define VSPM_IF_TMPL_PATCH_FIXED_BUF	(0x8000)
+
+/*
+ * With VSPM_IF_TMPL_PATCH_FIXED_BUF, the patched addresses are offsets
+ * from the head of the registered buffer buf_index[n] (see
+ * VSPM_IOC_CMD_BUF_REGISTER). n is 0-4 for src[0-4] and 5 for dst of
+ * VSP, 0 for fdp_out and 1-3 for fdp_ref[0-2] of FDP.
+ */
+#define VSPM_IF_TMPL_FIXED_BUF_NUM	(6)
+
+/* register a flat job descriptor (v2) as template */
+struct vspm_if_tmpl_reg_t {
+	unsigned long long job_param;
+	unsigned int job_size;
+	unsigned int id;
+};
+
+struct vspm_if_tmpl_addr_t {
+	unsigned int addr;
+	unsigned int addr_c0;
+	unsigned int addr_c1;
+};
+
+struct vspm_if_tmpl_entry_t {
+	struct vspm_if_tmpl_entry_req_t {
+		unsigned long long user_data;
+		unsigned long long cb_func;
+		unsigned long long hgo_addr;
+		unsigned long long hgt_addr;
+		unsigned int id;
+		unsigned int patch;
+		struct vspm_if_tmpl_addr_t src[5];
+		struct vspm_if_tmpl_addr_t dst;
+		struct vspm_if_tmpl_addr_t fdp_out;
+		struct vspm_if_tmpl_addr_t fdp_ref[3];
+		char priority;
+		unsigned char buf_index[VSPM_IF_TMPL_FIXED_BUF_NUM];
+		unsigned char reserved;
+	} req;
+	struct vspm_if_entry_v2_rsp_t rsp;
+};
+
+#define VSPM_IOC_CMD_TMPL_REGISTER \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_TMPL_REGISTER, \
+	struct vspm_if_tmpl_reg_t)
+#define VSPM_IOC_CMD_TMPL_UNREGISTER \
+	_IOW(VSPM_IOC_MAGIC, \
+	VSPM_CMD_TMPL_UNREGISTER, \
+	unsigned int)
+#define VSPM_IOC_CMD_TMPL_ENTRY \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_TMPL_ENTRY, \
+	struct vspm_if_tmpl_entry_t)
+
+/* for submission queue ring (common to 32bit and 64bit) */
+#define VSPM_IF_SQ_ENTRIES_MAX		(1024)
+#define VSPM_IF_SQ_ARENA_MAX		(4 * 1024 * 1024)
+
+/* offset of mmap() to map the submission queue ring */
+#define VSPM_IF_MMAP_SQ_RING		(0x00000000)
+
+/* setup flags */
+#define VSPM_IF_SQ_SETUP_THREAD		(0x0001)	/* kernel polling */
+
+/* ring flags */
+#define VSPM_IF_SQ_NEED_WAKEUP		(0x0001)	/* thread is sleeping */
+#define VSPM_IF_SQ_STALLED		(0x0002)	/* out of memory */
+
+/* operation code of submission queue entry */
+#define VSPM_IF_SQE_ENTRY_V2		(1)
+#define VSPM_IF_SQE_TMPL_ENTRY		(2)
+
+struct vspm_if_sq_setup_t {
+	unsigned int entries;		/* number of entries (power of 2) */
+	unsigned int arena_size;	/* size of descriptor arena */
+	unsigned int flags;
+	unsigned int idle_time;		/* idle time of thread (msec) */
+	unsigned int ring_size;		/* size to be mapped */
+	unsigned int reserved[3];
+};
+
+/*
+ * The ring begins with struct vspm_if_sq_ring_t. User space writes
+ * entries at sqe_off and advances tail, the driver advances head.
+ * A flat job descriptor (v2) of VSPM_IF_SQE_ENTRY_V2 is placed in the
+ * arena at arena_off, and req.v2.job_param holds the byte offset
+ * from the head of the arena.
+ * Jobs that the driver could not entry are reported to the callback
+ * (WAIT_INTERRUPT) with job_id = 0 and the error code in result.
+ * An entry of unknown opcode is reported as R_VSPM_PARAERR with
+ * user_data and cb_func read at the position of req.v2.
+ * The record of the report is reserved before an entry is consumed.
+ * If it cannot be allocated, head is not advanced and
+ * VSPM_IF_SQ_STALLED is set until the entry is consumed by a retry.
+ */
+struct vspm_if_sq_ring_t {
+	unsigned int head;
+	unsigned int tail;
+	unsigned int mask;
+	unsigned int entries;
+	unsigned int flags;
+	unsigned int sqe_off;
+	unsigned int arena_off;
+	unsigned int arena_size;
+	unsigned int reserved[8];
+};
+
+struct vspm_if_sqe_t {
+	unsigned int opcode;
+	unsigned int reserved;
+	union {
+		struct vspm_if_entry_v2_req_t v2;
+		struct vspm_if_tmpl_entry_req_t tmpl;
+	} req;
+};
+
+#define VSPM_IOC_CMD_SQ_SETUP \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_SQ_SETUP, \
+	struct vspm_if_sq_setup_t)
+#define VSPM_IOC_CMD_SQ_ENTER \
+	_IO(VSPM_IOC_MAGIC, VSPM_CMD_SQ_ENTER)
+
+/* for completion queue ring (common to 32bit and 64bit) */
+#define VSPM_IF_CQ_ENTRIES_MAX		(4096)
+
+/* offset of mmap() to map the completion queue ring */
+#define VSPM_IF_MMAP_CQ_RING		(0x10000000)
+
+struct vspm_if_cq_setup_t {
+	unsigned int entries;		/* number of entries (power of 2) */
+	unsigned int ring_size;		/* size to be mapped */
+	unsigned int reserved[2];
+};
+
+/*
+ * The ring begins with struct vspm_if_cq_ring_t. The driver writes
+ * entries at cqe_off and advances tail, user space advances head.
+ * Results of jobs with HGO/HGT output and results that overflow the
+ * ring are still reported to WAIT_INTERRUPT (overflow is counted).
+ */
+struct vspm_if_cq_ring_t {
+	unsigned int head;
+	unsigned int tail;
+	unsigned int mask;
+	unsigned int entries;
+	unsigned int overflow;
+	unsigned int cqe_off;
+	unsigned int reserved[10];
+};
+
+struct vspm_if_cqe_t {
+	unsigned long long job_id;
+	unsigned long long user_data;
+	unsigned long long cb_func;
+	long long result;
+};
+
+#define VSPM_IOC_CMD_CQ_SETUP \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_CQ_SETUP, \
+	struct vspm_if_cq_setup_t)
+#define VSPM_IOC_CMD_CQ_WAIT \
+	_IO(VSPM_IOC_MAGIC, VSPM_CMD_CQ_WAIT)
+
+/* for configuration and statistics (common to 32bit and 64bit) */
+#define VSPM_IF_ENTRY_POOL_DEPTH	(16)	/* default */
+#define VSPM_IF_ENTRY_POOL_MAX		(1024)
+#define VSPM_IF_DL_SIZE_MIN		(12288)	/* default */
+#define VSPM_IF_DL_SIZE_MAX		(262144)
+
+/* set before VSPM_IOC_CMD_INIT (0 means default) */
+struct vspm_if_config_t {
+	unsigned int entry_pool_depth;
+	unsigned int dl_size;		/* bytes of display list per job */
+	unsigned int reserved[6];
+};
+
+struct vspm_if_stats_t {
+	unsigned int entry_pool_depth;
+	unsigned int entry_pool_free;
+	unsigned int entry_pool_miss;	/* allocated out of pool */
+	unsigned int work_buff_num;
+	unsigned int work_buff_used;
+	unsigned int work_buff_peak;	/* high-water mark of used */
+	unsigned int work_mem_used;	/* bytes of DMA memory */
+	unsigned int work_mem_peak;
+	unsigned long long mem_reclaimed;	/* bytes (module-wide) */
+	unsigned int mem_cached;	/* idle bytes (module-wide) */
+	unsigned int table_num;		/* registered tables */
+	unsigned int dmabuf_num;	/* imported dma-bufs */
+	unsigned int userptr_num;	/* cached user pointer mappings */
+	unsigned int userptr_miss;	/* mappings that pinned pages */
+	unsigned int reserved[1];
+};
+
+#define VSPM_IOC_CMD_SET_CONFIG \
+	_IOW(VSPM_IOC_MAGIC, \
+	VSPM_CMD_SET_CONFIG, \
+	struct vspm_if_config_t)
+#define VSPM_IOC_CMD_GET_STATS \
+	_IOR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_GET_STATS, \
+	struct vspm_if_stats_t)
+
+/* for table cache (common to 32bit and 64bit) */
+#define VSPM_IF_CLUT_TBL_NUM_MAX	(256)
+#define VSPM_IF_TBL_NUM_MAX		(16384)
+
+/*
+ * A registered table is referenced by a vsp_dl_t that has virt_addr = 0,
+ * tbl_num = VSPM_IF_TBL_CACHED and the table id in hard_addr. It can be
+ * used as the color table of a CLUT (vsp_src_t.clut, up to
+ * VSPM_IF_CLUT_TBL_NUM_MAX entries), vsp_lut_t.lut and vsp_clu_t.clu.
+ * The table is not copied for each job.
+ * Registering an id that is already used replaces the table, jobs
+ * already entried keep using the previous one.
+ */
+#define VSPM_IF_TBL_CACHED		(0xFFFF)
+
+struct vspm_if_tbl_reg_t {
+	unsigned long long tbl_addr;	/* table (tbl_num * 8 bytes) */
+	unsigned int tbl_num;
+	unsigned int id;		/* 0 means assigned by driver */
+};
+
+#define VSPM_IOC_CMD_TBL_REGISTER \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_TBL_REGISTER, \
+	struct vspm_if_tbl_reg_t)
+#define VSPM_IOC_CMD_TBL_UNREGISTER \
+	_IOW(VSPM_IOC_MAGIC, \
+	VSPM_CMD_TBL_UNREGISTER, \
+	unsigned int)
+
+/* for dma-buf import (common to 32bit and 64bit) */
+#define VSPM_IF_DMABUF_MAX		(256)	/* per file descriptor */
+
+/*
+ * The dma-buf is attached to and mapped for the device, and the
+ * device address is returned in addr. It can be used for the image
+ * address (addr, addr_c0 and addr_c1 with the plane offset) of any
+ * job. Importing the same dma-buf again returns the same id and
+ * mapping without mapping it again, each import is released by
+ * VSPM_IOC_CMD_DMABUF_RELEASE. The id is released at once by the
+ * last release, and the mapping is released after the jobs of the fd
+ * entried before it are done, since jobs do not hold the buffer.
+ * The buffer must be contiguous in the device address space.
+ */
+struct vspm_if_dmabuf_import_t {
+	int fd;				/* dma-buf file descriptor */
+	unsigned int id;
+	unsigned int addr;		/* device address */
+	unsigned int size;
+};
+
+#define VSPM_IOC_CMD_DMABUF_IMPORT \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_DMABUF_IMPORT, \
+	struct vspm_if_dmabuf_import_t)
+#define VSPM_IOC_CMD_DMABUF_RELEASE \
+	_IOW(VSPM_IOC_MAGIC, \
+	VSPM_CMD_DMABUF_RELEASE, \
+	unsigned int)
+
+/* for fixed buffer table (common to 32bit and 64bit) */
+/*
+ * The dma-bufs are attached and mapped once when registered, and a
+ * template entry refers to them by index of the table
+ * (VSPM_IF_TMPL_PATCH_FIXED_BUF). The fd -1 is an empty entry.
+ * Only one table can be registered per file descriptor, the buffers are
+ * released after the last job using the table is done.
+ */
+struct vspm_if_buf_reg_t {
+	unsigned long long fds;		/* array of dma-buf fd (int) */
+	unsigned int num;		/* up to VSPM_IF_DMABUF_MAX */
+	unsigned int reserved;
+};
+
+#define VSPM_IOC_CMD_BUF_REGISTER \
+	_IOW(VSPM_IOC_MAGIC, \
+	VSPM_CMD_BUF_REGISTER, \
+	struct vspm_if_buf_reg_t)
+#define VSPM_IOC_CMD_BUF_UNREGISTER \
+	_IO(VSPM_IOC_MAGIC, VSPM_CMD_BUF_UNREGISTER)
+
+/* for image buffer allocation (common to 32bit and 64bit) */
+#define VSPM_IF_BUF_SIZE_MAX		(256 * 1024 * 1024)
+
+/*
+ * The image buffer is allocated by the driver and exported as dma-buf.
+ * It is mapped cached by mmap() of the dma-buf fd, so CPU access must
+ * be surrounded by DMA_BUF_IOCTL_SYNC. The buffer is also imported to
+ * this file descriptor (see VSPM_IOC_CMD_DMABUF_IMPORT), addr, addr_c0
+ * and addr_c1 are the device addresses of each plane.
+ */
+struct vspm_if_buf_alloc_t {
+	unsigned int width;
+	unsigned int height;
+	unsigned int stride;		/* bytes of a line (luma or RGB) */
+	unsigned int planes;		/* 1 to 3 */
+	unsigned int height_c;		/* lines of a chroma plane */
+	unsigned int stride_c;		/* bytes of a line of chroma plane */
+	int fd;				/* out: dma-buf file descriptor */
+	unsigned int id;		/* out: imported dma-buf id */
+	unsigned int addr;		/* out */
+	unsigned int addr_c0;		/* out */
+	unsigned int addr_c1;		/* out */
+	unsigned int size;		/* out */
+};
+
+#define VSPM_IOC_CMD_BUF_ALLOC \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_BUF_ALLOC, \
+	struct vspm_if_buf_alloc_t)
+
+/* for user pointer image buffer (common to 32bit and 64bit) */
+#define VSPM_IF_USERPTR_CACHE_MAX	(32)	/* per file descriptor */
+
+/* unmap flags */
+#define VSPM_IF_USERPTR_EVICT		(0x0001)	/* drop from cache */
+
+/*
+ * The user pages are pinned and mapped for the device (it needs to be
+ * contiguous in the device address space, i.e. behind IOMMU), and the
+ * device address is returned in addr. Mappings are cached by
+ * (process, user_addr, size), mapping the same area again skips the
+ * pinning. Each map is paired with an unmap after the jobs using it
+ * are done. Unused mappings are kept until the cache is full, so use
+ * VSPM_IF_USERPTR_EVICT before the memory is freed or reused.
+ * Since jobs do not hold the mapping, the CPU sync of unmap and the
+ * unpinning of an evicted mapping are done after the jobs of the fd
+ * entried before the unmap are done.
+ */
+struct vspm_if_userptr_t {
+	unsigned long long user_addr;
+	unsigned int size;
+	unsigned int flags;
+	unsigned int addr;		/* out: device address */
+	unsigned int reserved;
+};
+
+#define VSPM_IOC_CMD_USERPTR_MAP \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_USERPTR_MAP, \
+	struct vspm_if_userptr_t)
+#define VSPM_IOC_CMD_USERPTR_UNMAP \
+	_IOW(VSPM_IOC_MAGIC, \
+	VSPM_CMD_USERPTR_UNMAP, \
+	struct vspm_if_userptr_t)
+
+/* for job entry with fence (common to 32bit and 64bit) */
+#define VSPM_IF_FENCE_OUT		(0x0001)	/* create out_fence */
+#define VSPM_IF_FENCE_IN		(0x0002)	/* wait in_fences */
+#define VSPM_IF_IN_FENCE_MAX		(8)
+
+/*
+ * opcode and req are the same as struct vspm_if_sqe_t. With
+ * VSPM_IF_FENCE_OUT, out_fence returns a sync_file fd that is signaled
+ * when the job is done (with an error if the job failed or was
+ * canceled). The fence can be passed to other drivers (e.g. DRM
+ * IN_FENCE_FD) without waiting in user space.
+ * With VSPM_IF_FENCE_IN, in_fences points to an array of in_fence_num
+ * sync_file fds, and the job is entried to VSP manager when all of
+ * them are signaled. rsp.job_id is 0 in this case (the job cannot be
+ * canceled), and an error of in-fence or entry is reported to the
+ * callback with job_id = 0 like the submission queue.
+ */
+struct vspm_if_fence_entry_t {
+	unsigned int opcode;
+	unsigned int flags;
+	union {
+		struct vspm_if_entry_v2_req_t v2;
+		struct vspm_if_tmpl_entry_req_t tmpl;
+	} req;
+	struct vspm_if_entry_v2_rsp_t rsp;
+	unsigned long long in_fences;	/* int array */
+	unsigned int in_fence_num;
+	int out_fence;			/* out: sync_file fd */
+};
+
+#define VSPM_IOC_CMD_ENTRY_FENCE \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_ENTRY_FENCE, \
+	struct vspm_if_fence_entry_t)
+
+/* for job graph (common to 32bit and 64bit) */
+#define VSPM_IF_GRAPH_NODE_MAX		(32)
+
+/*
+ * The nodes are entried in order like VSPM_IOC_CMD_ENTRY_BATCH. A node
+ * waits until the earlier nodes set in deps (bit n for node[n]) are
+ * done, as well as its in_fences, and it is entried to VSP manager in
+ * the driver without returning to user space. When a prerequisite
+ * failed, the node is reported to the callback with job_id = 0.
+ * Jobs of other graphs can be waited for with their out_fence.
+ */
+struct vspm_if_graph_node_t {
+	struct vspm_if_fence_entry_t entry;
+	unsigned int deps;
+	unsigned int reserved;
+};
+
+struct vspm_if_entry_graph_t {
+	unsigned long long node;	/* struct vspm_if_graph_node_t array */
+	unsigned int num;
+	unsigned int done;
+};
+
+#define VSPM_IOC_CMD_ENTRY_GRAPH \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_ENTRY_GRAPH, \
+	struct vspm_if_entry_graph_t)
+
+/* for FDP to VSP pipeline (common to 32bit and 64bit) */
+
+/*
+ * VSPM_IOC_CMD_PIPE_INIT opens a VSP handle in addition to the FDP
+ * handle of VSPM_IOC_CMD_INIT. After that, VSP jobs of the fd are
+ * entried to the VSP handle, and FDP jobs to the FDP handle.
+ */
+struct vspm_if_pipe_init_t {
+	unsigned int use_ch;
+	unsigned short mode;
+	unsigned short reserved;
+};
+
+/*
+ * Both stages are template entries. The output buffer of FDP
+ * (fdp_out, or the registered one) is patched to src[src] of VSP,
+ * the VSP template must describe it as the FDP output format.
+ * The VSP stage is entried in the driver when the FDP stage is done.
+ * done returns the number of the entried stages.
+ */
+struct vspm_if_pipe_entry_t {
+	struct vspm_if_fence_entry_t fdp;
+	struct vspm_if_fence_entry_t vsp;
+	unsigned int src;
+	unsigned int done;
+};
+
+#define VSPM_IOC_CMD_PIPE_INIT \
+	_IOW(VSPM_IOC_MAGIC, \
+	VSPM_CMD_PIPE_INIT, \
+	struct vspm_if_pipe_init_t)
+#define VSPM_IOC_CMD_ENTRY_PIPE \
+	_IOWR(VSPM_IOC_MAGIC, \
+	VSPM_CMD_ENTRY_PIPE, \
+	struct vspm_if_pipe_entry_t)
 
 #endif /* __VSPM_IF_H__ */